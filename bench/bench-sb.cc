@@ -124,5 +124,29 @@ int main(int argc, char * * argv)
         test(pmrd, pmrd, reps, "pmrd/pmrd");
 
     }
+// ply_fixed collapses compact axes and unrolls fully below RA_UNROLL. Build with -DRA_UNROLL=0 to compare.
+    auto small = [&tr]<int N>(ra::ic_t<N>, int reps){
+        tr.section("small fixed size kernel ", N, "x", N, " RA_UNROLL ", RA_UNROLL);
+        ra::Small<double, N, N> a = ra::_0 - ra::_1, b = ra::_0 + ra::_1, c = 0;
+        Benchmark bm { reps, 3 };
+        auto report = [&](std::string const & stag, auto && ref, auto && f){
+            auto bv = bm.run([&]{ f(c, a, b); });
+            c = 0;
+            f(c, a, b);
+            tr.info(Benchmark::report(bv, N*N), " ", stag).test_eq(ref, c);
+        };
+        report("ply_fixed", a*b,
+               [](auto & c, auto const & a, auto const & b){ c += a*b; });
+        report("ply_fixed, not compact", a*transpose(b),
+               [](auto & c, auto const & a, auto const & b){ c += a*transpose(b); });
+        report("ply_ravel", a*b,
+               [](auto & c, auto const & a, auto const & b){
+                   ra::ply_ravel(map([](auto & c, auto a, auto b){ c += a*b; }, c, a, b));
+               });
+    };
+    small(ra::ic<2>, 10*reps);
+    small(ra::ic<3>, 10*reps);
+    small(ra::ic<4>, 10*reps);
+    small(ra::ic<8>, reps);
     return tr.summary();
 }
@@ -63,6 +63,10 @@ int main()
               [](auto & c, auto const & a){
                   c += a; // bump c after each row, so it cannot be raveled
               });
+        bench("reduce", m, n, reps,
+              [](auto & c, auto const & a){
+                  c += ra::reduce_axis<1>(std::plus<>(), a);
+              });
     };
 
     bench_all(1, 1000000, 20);
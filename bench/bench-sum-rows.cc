@@ -79,6 +79,10 @@ int main()
               [](auto & c, auto const & a){
                   c += transpose(a);
               });
+        bench("reduce", m, n, reps,
+              [](auto & c, auto const & a){
+                  c += ra::reduce_axis<0>(std::plus<>(), a);
+              });
 
         std::ranges::sort(v, [](auto & a, auto & b){ return a.med<b.med; });
         std::println(std::cout, "Best > {}{}{:nS{ / }{}}{}.", ra::esc::cyan, ra::esc::bold, map(&Benchmark::Value::name, v), ra::esc::reset);
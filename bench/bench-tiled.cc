@@ -0,0 +1,61 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/bench - Tiled vs untiled traversal with mismatched layouts.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#include <iostream>
+#include <iomanip>
+#include "ra/test.hh"
+
+using std::cout, std::endl, std::flush, ra::TestRecorder, ra::Benchmark;
+using real = double;
+
+int main()
+{
+    TestRecorder tr(cout);
+    cout.precision(4);
+
+    auto bench = [&tr](char const * tag, int n, int reps, auto && f){
+        ra::Big<real, 2> a({n, n}, ra::_0 - ra::_1);
+        ra::Big<real, 2> b({n, n}, ra::_0 + 2*ra::_1);
+        ra::Big<real, 2> ref({n, n}, a + transpose(b));
+        ra::Big<real, 2> c({n, n}, ra::none);
+
+        auto bv = Benchmark().reps(reps).runs(3)
+            .once_f([&](auto && repeat) { repeat([&]() { f(c, a, b); }); });
+        tr.info(Benchmark::report(bv, n*n), " ", tag)
+            .test_eq(ref, c);
+    };
+
+    auto bench_all = [&](int n, int reps){
+        tr.section(n, " x ", n, " times ", reps);
+        bench("untiled", n, reps,
+              [](auto & c, auto const & a, auto const & b){
+                  c = a + transpose(b);
+              });
+        bench("tiled auto", n, reps,
+              [](auto & c, auto const & a, auto const & b){
+                  for_each(ra::tile_t {}, [](auto & c, auto && x){ c = x; }, c, a + transpose(b));
+              });
+        bench("tiled 16x16", n, reps,
+              [](auto & c, auto const & a, auto const & b){
+                  for_each(ra::tile_t {16, 16}, [](auto & c, auto && x){ c = x; }, c, a + transpose(b));
+              });
+        bench("tiled 32x128", n, reps,
+              [](auto & c, auto const & a, auto const & b){
+                  for_each(ra::tile_t {32, 128}, [](auto & c, auto && x){ c = x; }, c, a + transpose(b));
+              });
+    };
+
+    bench_all(100, 1000);
+    bench_all(500, 40);
+    bench_all(1000, 10);
+    bench_all(2000, 3);
+    bench_all(4000, 1);
+
+    return tr.summary();
+}
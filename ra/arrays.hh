@@ -10,6 +10,7 @@
 #pragma once
 #include "ply.hh"
 #include <memory>
+#include <memory_resource>
 
 namespace ra {
 
@@ -221,6 +222,81 @@ using Small = SmallArray<T, ic_t<c_dimv(std::array<dim_t, sizeof...(lens)>{lens
 
 template <class A0, class ... A> SmallArray(A0, A ...) -> Small<A0, 1+sizeof...(A)>;
 
+// Allocation for Big. By default this goes to std::allocator, but it can be sent to a memory resource for the duration of a
+// scope in the current thread. Arrays allocated in a scope keep the resource, and must not outlive it. As with
+// std::pmr::polymorphic_allocator, the resource doesn't propagate on assignment, so moving to an array with another resource
+// moves the elements.
+
+inline thread_local std::pmr::memory_resource * alloc_resource = nullptr;
+
+// N is the alignment in bytes, at least alignof(T).
+template <class T, std::size_t N=0>
+struct scope_allocator
+{
+    using value_type = T;
+    template <class U> struct rebind { using other = scope_allocator<U, N>; };
+    constexpr static std::size_t align = std::max(N, alignof(T));
+    static_assert(0==(align & (align-1)), "Bad alignment.");
+    std::pmr::memory_resource * r = nullptr;
+    constexpr scope_allocator() noexcept { if !consteval { r = alloc_resource; } }
+    template <class U, std::size_t M> constexpr scope_allocator(scope_allocator<U, M> const & a) noexcept: r(a.r) {}
+    constexpr scope_allocator select_on_container_copy_construction() const { return {}; }
+    constexpr T *
+    allocate(std::size_t n)
+    {
+        if consteval {
+            return std::allocator<T> {}.allocate(n);
+        } else if (r) {
+            return static_cast<T *>(r->allocate(n*sizeof(T), align));
+        } else if constexpr (align>alignof(T)) {
+            return static_cast<T *>(::operator new(n*sizeof(T), std::align_val_t(align)));
+        } else {
+            return std::allocator<T> {}.allocate(n);
+        }
+    }
+    constexpr void
+    deallocate(T * p, std::size_t n)
+    {
+        if consteval {
+            std::allocator<T> {}.deallocate(p, n);
+        } else if (r) {
+            r->deallocate(p, n*sizeof(T), align);
+        } else if constexpr (align>alignof(T)) {
+            ::operator delete(p, n*sizeof(T), std::align_val_t(align));
+        } else {
+            std::allocator<T> {}.deallocate(p, n);
+        }
+    }
+    template <class U, std::size_t M> constexpr bool operator==(scope_allocator<U, M> const & b) const noexcept { return r==b.r; }
+};
+
+struct alloc_scope
+{
+    std::pmr::memory_resource * r;
+    explicit alloc_scope(std::pmr::memory_resource * r_): r(std::exchange(alloc_resource, r_)) {}
+    ~alloc_scope() { alloc_resource = r; }
+    alloc_scope(alloc_scope const &) = delete;
+    alloc_scope & operator=(alloc_scope const &) = delete;
+    static std::pmr::memory_resource * upstream() { return alloc_resource ? alloc_resource : std::pmr::new_delete_resource(); }
+};
+
+// Monotonic arena. Deallocation does nothing, and all the memory is released at the end of the scope.
+struct arena_scope
+{
+    std::pmr::monotonic_buffer_resource arena;
+    alloc_scope scope;
+    explicit arena_scope(std::size_t initial=1<<20): arena(initial, alloc_scope::upstream()), scope(&arena) {}
+    arena_scope(void * buffer, std::size_t size): arena(buffer, size, alloc_scope::upstream()), scope(&arena) {}
+};
+
+// Size class pool. Deallocated blocks are reused for later allocations of the same class. Not thread safe.
+struct pool_scope
+{
+    std::pmr::unsynchronized_pool_resource pool;
+    alloc_scope scope;
+    explicit pool_scope(std::pmr::pool_options const & o={}): pool(o, alloc_scope::upstream()), scope(&pool) {}
+};
+
 template <class V>
 struct storage_traits
 {
@@ -248,6 +324,40 @@ struct storage_traits<std::shared_ptr<P>>
     constexpr static auto data(auto & v) { return v.get(); }
 };
 
+// Storage aligned to N bytes. With pad, the rows of arrays of rank > 1 are also padded to a multiple of N bytes.
+template <class T, std::size_t N, bool pad_=true>
+struct aligned_store: std::vector<T, default_init_allocator<T, scope_allocator<T, N>>>
+{
+    using std::vector<T, default_init_allocator<T, scope_allocator<T, N>>>::vector;
+};
+
+template <class T, std::size_t N, bool pad_>
+struct storage_traits<aligned_store<T, N, pad_>>: storage_traits<std::vector<T, default_init_allocator<T, scope_allocator<T, N>>>>
+{
+    using V = aligned_store<T, N, pad_>;
+    constexpr static auto create(dim_t n) { RA_CK(0<=n, "Bad size ", n, "."); return V(n); }
+    constexpr static dim_t pad = (pad_ && 0==N%sizeof(T)) ? N/sizeof(T) : 1;
+};
+
+// Pad rows of C order dv to a multiple of pad elements, avoiding row steps that are a multiple of alias elements. Return the span.
+constexpr dim_t
+pad_dimv(auto & dv, dim_t pad, dim_t alias)
+{
+    rank_t r = ra::size(dv);
+    if (r<2) {
+        return dimv_size(dv);
+    }
+    dim_t s = (dv[r-1].len+pad-1)/pad*pad;
+    if (pad<alias && 0<s && 0==s%alias) {
+        s += pad;
+    }
+    for (rank_t k=r-1; --k>=0;) {
+        dv[k].step = s;
+        s *= dv[k].len;
+    }
+    return s;
+}
+
 // FIXME Requires copyable T. store(x) avoids it for Big, but not for Unique. Should construct in place like std::vector.
 template <class Store, class Dimv_>
 struct Array
@@ -269,6 +379,8 @@ struct Array
 #undef RAC
     Store store;
     using T = storage_traits<Store>::T;
+    constexpr static dim_t pad = [](){ if constexpr (requires { storage_traits<Store>::pad; }) return storage_traits<Store>::pad; else return dim_t(1); }();
+    constexpr static bool padded = 1<pad && (1<R || ANY==R);
     constexpr auto data(this auto && sf) { return storage_traits<Store>::data(sf.store); }
     constexpr auto view() { return View<T *, Dimv const &>(dimv, data()); }
     constexpr auto view() const { return View<T const *, Dimv const &>(dimv, data()); }
@@ -293,8 +405,33 @@ struct Array
 #define RA_BRACES(N) constexpr Array(braces<T, N> x) requires (R==ANY): Array(braces_shape<T, N>(x), x) {}
     RA_FE(RA_BRACES, 1, 2, 3, 4)
 #undef RA_BRACES
-    constexpr Array(auto && s, none_t) { store = storage_traits<Store>::create(filldimv(iter(RA_FW(s)), dimv)); }
-    constexpr Array(auto && s, auto const & x): Array(RA_FW(s), none) { view() = x; }
+    constexpr dim_t
+    filldims(auto && s)
+    {
+        dim_t n = filldimv(RA_FW(s), dimv);
+        if constexpr (padded) {
+            n = pad_dimv(dimv, pad, std::max(dim_t(1), dim_t(4096/sizeof(T))));
+        }
+        return n;
+    }
+    constexpr Array(auto && s, none_t)
+    {
+        dim_t n = filldims(iter(RA_FW(s)));
+        RA_PROBE("Array", n, n*dim_t(sizeof(T)));
+        store = storage_traits<Store>::create(n);
+    }
+    constexpr Array(auto && s, auto const & x): Array(RA_FW(s), none)
+    {
+        if !consteval {
+            if (1!=init_par.nthreads) {
+                par_t p = std::exchange(assign_par, par_t { .nthreads=init_par.nthreads, .grain=init_par.grain, .pin=true });
+                try { view() = x; } catch (...) { assign_par = p; throw; }
+                assign_par = p;
+                return;
+            }
+        }
+        view() = x;
+    }
     constexpr Array(auto && s, std::initializer_list<T> x): Array(RA_FW(s), none) { to_ravel(x, *this); }
     constexpr Array(std::array<dim_t, 0> s, auto const & x): Array(iter(s), x) {};
     constexpr Array(std::array<dim_t, 0> s, std::initializer_list<T> x): Array(iter(s), x) {}
@@ -303,17 +440,17 @@ struct Array
     template <int N> constexpr Array(dim_t (&&s)[N], auto * p): Array(iter(s), none) { std::ranges::copy_n(p, size(), begin()); }
 #define RA_CR(left) if constexpr (ANY==R) { RA_CK(left rank()); } else { static_assert(left R); }
 // resize first axis or full shape. Only for some kinds of store.
-    constexpr void resize(dim_t const s) { RA_CR(0<); dimv[0].len = s; store.resize(size()); }
-    constexpr void resize(dim_t const s, T const & t) { RA_CR(0<); dimv[0].len = s; store.resize(size(), t); }
-    constexpr void resize(auto const & s) requires (1==rank_s(s)) { store.resize(filldimv(iter(s), dimv)); }
+    constexpr void resize(dim_t const s) { RA_CR(0<); dimv[0].len = s; store.resize(padded ? s*dimv[0].step : size()); }
+    constexpr void resize(dim_t const s, T const & t) { RA_CR(0<); dimv[0].len = s; store.resize(padded ? s*dimv[0].step : size(), t); }
+    constexpr void resize(auto const & s) requires (1==rank_s(s)) { store.resize(filldims(iter(s))); }
 // auto && + RA_FW wouldn't work for push_back(brace-enclosed-list). p1219??
     constexpr void push_back(T && t) { RA_CR(1==); store.push_back(std::move(t)); ++dimv[0].len; }
     constexpr void push_back(T const & t) { RA_CR(1==); store.push_back(t); ++dimv[0].len; }
     constexpr void emplace_back(auto && ... a) { RA_CR(1==); store.emplace_back(RA_FW(a) ...); ++dimv[0].len; }
     constexpr void pop_back() { RA_CR(1==); RA_CK(0<dimv[0].len, "Empty array pop_back()."); --dimv[0].len; store.pop_back(); }
 #undef RA_CR
-    constexpr auto begin(this auto && sf) { return sf.data(); }
-    constexpr auto end(this auto && sf) { return sf.data()+sf.size(); }
+    constexpr auto begin(this auto && sf) { if constexpr (padded) return RA_FW(sf).view().begin(); else return sf.data(); }
+    constexpr auto end(this auto && sf) { if constexpr (padded) return std::default_sentinel; else return sf.data()+sf.size(); }
     constexpr decltype(auto) back(this auto && sf) { return RA_FW(sf).view().back(); }
     constexpr decltype(auto) operator()(this auto && sf, auto && ... i) { return from(RA_FW(sf), RA_FW(i) ...); }
     constexpr decltype(auto) operator[](this auto && sf, auto && ... i) { return from(RA_FW(sf), RA_FW(i) ...); }
@@ -322,8 +459,9 @@ struct Array
 };
 
 template <rank_t R=ANY> using BigDim1 = std::conditional_t<1==R, std::array<SDim<dim_t, ic_t<1>>, 1>, BigDimv<R>>;
-template <class T, rank_t R=ANY> using Big = Array<vector_default_init<T>, BigDim1<R>>;
+template <class T, rank_t R=ANY, class A=scope_allocator<T>> using Big = Array<std::vector<T, default_init_allocator<T, A>>, BigDim1<R>>;
 template <class T, rank_t R=ANY> using Unique = Array<std::unique_ptr<T []>, BigDim1<R>>;
+template <class T, rank_t R=ANY, std::size_t N=64, bool pad=true> using Aligned = Array<aligned_store<T, N, pad>, BigDim1<R>>;
 template <class T, rank_t R=ANY> using Shared = Array<std::shared_ptr<T>, BigDim1<R>>;
 
 // rely on std::swap; else ambiguous
@@ -383,7 +521,7 @@ template <class E>
 using concrete_type = concrete_type_<E>::type;
 
 template <class E> constexpr auto
-concrete(E && e) { return concrete_type<E>(RA_FW(e)); }
+concrete(E && e) { RA_PROBE("concrete", ra::size(e)); return concrete_type<E>(RA_FW(e)); }
 
 template <class E, class ... X> constexpr auto
 copy_shape(E && e, X && ... x) requires (ANY!=size_s<E>()) { return concrete_type<E>(RA_FW(x) ...); }
@@ -436,7 +574,7 @@ transpose_dims(auto const & s, auto const & src, auto & dst)
     std::ranges::fill(dst, Dim {UNB, 0});
     for (int k=0; int sk: s) {
         dst[sk].step += src[k].step;
-        dst[sk].len = dst[sk].len>=0 ? std::min(dst[sk].len, src[k].len) : src[k].len;
+        dst[sk].len = UNB==src[k].len ? dst[sk].len : dst[sk].len>=0 ? std::min(dst[sk].len, src[k].len) : src[k].len;
         ++k;
     }
 }
@@ -461,6 +599,74 @@ template <class T, int N> constexpr auto transpose(Slice auto && a, T (&&s)[N])
 constexpr auto transpose(Slice auto && a) { return transpose(RA_FW(a), ilist<1, 0>); }
 constexpr auto diag(Slice auto && a) { return transpose(RA_FW(a), ilist<0, 0>); };
 
+// View ops on expressions, beaten down to the leaves. See cellview(). FIXME runtime axes.
+
+template <int ... I> constexpr std::array<int, sizeof...(I)> axes_s = { I ... };
+
+template <int ... I>
+constexpr auto
+transpose(Iterator auto && a, ilist_t<I ...> s)
+{
+    using A = std::decay_t<decltype(a)>;
+    if constexpr (ANY!=rank_s<A>()) {
+        static_assert(rank_s<A>()==sizeof...(I), "Bad rank for transposed axes.");
+    } else {
+        RA_CK(rank(a)==sizeof...(I), "Bad rank ", rank(a), " for ", sizeof...(I), " transposed axes.");
+    }
+    if constexpr (0==sizeof...(I)) {
+        return a;
+    } else if constexpr (is_cell<A>) {
+        return iter(transpose(cellview(a), s));
+    } else if constexpr (is_reframe<A>) {
+        return [&]<class B, int ... di, class J>(Reframe<B, ilist_t<di ...>, J> const & r){
+            return transpose(r.a, ilist<axes_s<I ...>[di] ...>);
+        }(a);
+    } else if constexpr (is_match<A>) {
+        return beat_children(a, [](auto const & p){
+            constexpr rank_t r = rank_s<decltype(p)>();
+            static_assert(ANY!=r, "Cannot transpose leaf of dynamic rank.");
+            return [&]<int ... k>(ilist_t<k ...>){ return transpose(p, ilist<axes_s<I ...>[k] ...>); }(mp::iota<r> {});
+        });
+    } else {
+        static_assert(is_order<I ...>, "Cannot beat transpose into expression.");
+        return reframe(a, s);
+    }
+}
+
+constexpr auto transpose(Iterator auto && a) { return transpose(RA_FW(a), ilist<1, 0>); }
+constexpr auto diag(Iterator auto && a) { return transpose(RA_FW(a), ilist<0, 0>); };
+
+template <class K=ic_t<0>>
+constexpr auto
+reverse(Iterator auto && a, K k = K {})
+{
+    using A = std::decay_t<decltype(a)>;
+    static_assert(is_ctype<K>, "Reverse of expression requires static axis.");
+    if constexpr (ANY!=rank_s<A>()) {
+        static_assert(inside(k, rank_s<A>()), "Bad axis for rank.");
+    } else {
+        RA_CK(inside(k, rank(a)), "Bad axis ", k, " for rank ", rank(a), ".");
+    }
+    if constexpr (is_cell<A>) {
+        return iter(reverse(cellview(a), k));
+    } else if constexpr (is_reframe<A>) {
+        if constexpr (constexpr int l=A::orig(k); l>=0) {
+            auto b = reverse(a.a, ic<l>);
+            return [&]<class B, class Dest, class J>(Reframe<B, Dest, J> const &){ return Reframe<decltype(b), Dest> { std::move(b) }; }(a);
+        } else {
+            return a;
+        }
+    } else if constexpr (is_match<A>) {
+        return beat_children(a, [](auto const & p){
+            constexpr rank_t r = rank_s<decltype(p)>();
+            static_assert(ANY!=r, "Cannot reverse leaf of dynamic rank.");
+            if constexpr (K::value<r) { return reverse(p, K {}); } else { return p; }
+        });
+    } else {
+        static_assert(false, "Cannot beat reverse into expression.");
+    }
+}
+
 constexpr auto
 cat(auto && a1, auto && a2) requires (ra::size_s(a1)>=0 && ra::size_s(a2)>=0)
 {
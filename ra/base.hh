@@ -250,6 +250,9 @@ template <class T, class A=std::allocator<T>>
 struct default_init_allocator: public A
 {
     using traits = std::allocator_traits<A>;
+    default_init_allocator() = default;
+    constexpr default_init_allocator(A const & a) noexcept: A(a) {}
+    template <class U, class B> constexpr default_init_allocator(default_init_allocator<U, B> const & a) noexcept: A(static_cast<B const &>(a)) {}
     template <class U>
     struct rebind
     {
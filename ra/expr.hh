@@ -45,10 +45,18 @@
 
 namespace ra {
 
-// Assign ops for Iterators, might be different for Views.
+// Assign ops for Iterators, might be different for Views. set is true for plain =, cf ply_assign().
+
+template <bool set_, class Op>
+struct assign_op: Op
+{
+    constexpr static bool set = set_;
+};
+
+template <bool set> constexpr auto make_assign_op(auto op) { return assign_op<set, decltype(op)> { op }; }
 
 #define RA_ASSIGNOPS_LINE(OP)                                           \
-    for_each([](auto && y, auto && x){ /* [ra5] */ RA_FW(y) OP RA_FW(x); }, *this, RA_FW(x))
+    ply_assign(make_assign_op<std::string_view(#OP)=="=">([](auto && y, auto && x){ /* [ra5] */ RA_FW(y) OP RA_FW(x); }), *this, RA_FW(x))
 #define RA_ASSIGNOPS_DEFAULT(OP)                                        \
     constexpr void operator OP(auto && x) { RA_ASSIGNOPS_LINE(OP); }
 // Restate for iterator classes since a template doesn't replace the copy assignment. Cf RA_ASSIGNOPS on views [ra34][ra38].
@@ -0,0 +1,204 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra - Arrays backed by a memory mapped file, huge pages (POSIX).
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+// This header isn't included by ra.hh.
+
+#pragma once
+#include "ra.hh"
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ra {
+
+// read: PROT_READ, needs T const. copy: MAP_PRIVATE, writes aren't seen in the file. write: MAP_SHARED, the file is
+// created or extended as needed.
+enum class mmap_mode { read, copy, write };
+enum class mmap_advice { normal, sequential, random, willneed };
+
+// Storage for Mmap. The mapping starts at a page boundary, so the data may be at an offset from it.
+template <class T>
+struct mmap_store
+{
+    void * base = nullptr;
+    std::size_t bytes = 0;
+    T * p = nullptr;
+    constexpr mmap_store() = default;
+    mmap_store(void * base, std::size_t bytes, T * p): base(base), bytes(bytes), p(p) {}
+    mmap_store(mmap_store && x): base(std::exchange(x.base, nullptr)), bytes(std::exchange(x.bytes, 0)), p(std::exchange(x.p, nullptr)) {}
+    mmap_store & operator=(mmap_store && x) { std::swap(base, x.base); std::swap(bytes, x.bytes); std::swap(p, x.p); return *this; }
+    ~mmap_store() { if (base) { ::munmap(base, bytes); } }
+    T * data() const { return p; }
+};
+
+inline void
+mmap_fail(char const * what, std::string const & path)
+{
+    throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path);
+}
+
+// Anonymous mapping, for Array(shape, x).
+template <class U>
+struct storage_traits<mmap_store<U>>
+{
+    using T = U;
+    using V = mmap_store<T>;
+    static V
+    create(dim_t n)
+    {
+        RA_CK(0<=n, "Bad size ", n, ".");
+        if (0==n) {
+            return V {};
+        }
+        std::size_t bytes = n*sizeof(T);
+        void * base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED==base) {
+            mmap_fail("mmap", "(anonymous)");
+        }
+        return V(base, bytes, static_cast<T *>(base));
+    }
+    constexpr static auto data(auto & v) { return v.p; }
+};
+
+template <class T, rank_t R=ANY> using Mmap = Array<mmap_store<T>, BigDim1<R>>;
+
+// Map the file at path from offset bytes as an array of the given shape.
+template <class T, rank_t R=ANY>
+Mmap<T, R>
+map_file(std::string const & path, auto const & shape, mmap_mode mode=mmap_mode::read, off_t offset=0)
+{
+    static_assert(std::is_trivially_copyable_v<std::remove_const_t<T>>, "Bad type for mmap.");
+    RA_CK(0<=offset, "Bad offset ", offset, ".");
+// the mode is a runtime argument, so this can't be a static_assert.
+    if (mmap_mode::read==mode && !std::is_const_v<T>) {
+        errno = EINVAL;
+        mmap_fail("read mode needs T const:", path);
+    }
+    Mmap<T, R> a;
+    std::size_t bytes = filldimv(iter(shape), a.dimv)*sizeof(T);
+    int fd = ::open(path.c_str(), mmap_mode::write==mode ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd<0) {
+        mmap_fail("open", path);
+    }
+    struct stat st;
+    if (0!=::fstat(fd, &st)) {
+        ::close(fd);
+        mmap_fail("fstat", path);
+    }
+    if (off_t(offset+bytes)>st.st_size) {
+        if (mmap_mode::write!=mode) {
+            ::close(fd);
+            errno = EINVAL;
+            mmap_fail("file too short:", path);
+        } else if (0!=::ftruncate(fd, offset+bytes)) {
+            ::close(fd);
+            mmap_fail("ftruncate", path);
+        }
+    }
+    if (0<bytes) {
+        off_t page = ::sysconf(_SC_PAGESIZE);
+        off_t skip = offset % page;
+        int prot = mmap_mode::read==mode ? PROT_READ : PROT_READ | PROT_WRITE;
+        int flags = mmap_mode::write==mode ? MAP_SHARED : MAP_PRIVATE;
+        void * base = ::mmap(nullptr, bytes+skip, prot, flags, fd, offset-skip);
+        if (MAP_FAILED==base) {
+            ::close(fd);
+            mmap_fail("mmap", path);
+        }
+        a.store = mmap_store<T>(base, bytes+skip, reinterpret_cast<T *>(static_cast<char *>(base)+skip));
+    }
+    ::close(fd);
+    return a;
+}
+
+template <class T, rank_t R=ANY, int N>
+Mmap<T, R>
+map_file(std::string const & path, dim_t (&&shape)[N], mmap_mode mode=mmap_mode::read, off_t offset=0)
+{
+    return map_file<T, R>(path, std::to_array(shape), mode, offset);
+}
+
+// Resource for Big that puts allocations of at least threshold bytes on their own anonymous mapping, aligned to huge pages
+// and with madvise(MADV_HUGEPAGE). Smaller allocations go upstream. The pages aren't touched, cf init_par.
+struct huge_resource: std::pmr::memory_resource
+{
+    constexpr static std::size_t page = 1<<21;
+    std::size_t threshold;
+    std::pmr::memory_resource * up;
+    explicit huge_resource(std::size_t threshold_=page, std::pmr::memory_resource * up_=alloc_scope::upstream())
+        : threshold(threshold_), up(up_) {}
+    static std::size_t span(std::size_t n) { return (n+page-1)/page*page; }
+    void *
+    do_allocate(std::size_t n, std::size_t a) override
+    {
+        if (n<threshold || a>page) {
+            return up->allocate(n, a);
+        }
+        std::size_t len = span(n);
+        void * q = ::mmap(nullptr, len+page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED==q) {
+            throw std::bad_alloc();
+        }
+        char * b = static_cast<char *>(q);
+        char * p = b + (page - reinterpret_cast<std::uintptr_t>(b) % page) % page;
+        if (p>b) { ::munmap(b, p-b); }
+        if (b+len+page>p+len) { ::munmap(p+len, b+len+page-(p+len)); }
+#ifdef MADV_HUGEPAGE
+        ::madvise(p, len, MADV_HUGEPAGE); // only a hint
+#endif
+        return p;
+    }
+    void
+    do_deallocate(void * p, std::size_t n, std::size_t a) override
+    {
+        if (n<threshold || a>page) {
+            up->deallocate(p, n, a);
+        } else {
+            ::munmap(p, span(n));
+        }
+    }
+    bool do_is_equal(std::pmr::memory_resource const & o) const noexcept override { return this==&o; }
+};
+
+struct huge_scope
+{
+    huge_resource huge;
+    alloc_scope scope;
+    explicit huge_scope(std::size_t threshold=huge_resource::page): huge(threshold), scope(&huge) {}
+};
+
+// Hint the kernel about the access pattern.
+template <class T, class Dimv>
+void
+advise(Array<mmap_store<T>, Dimv> const & a, mmap_advice advice)
+{
+    if (a.store.base) {
+        int h = std::array { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED } [int(advice)];
+        if (0!=::madvise(a.store.base, a.store.bytes, h)) {
+            mmap_fail("madvise", "mapping");
+        }
+    }
+}
+
+// Write back changes to a mapping in write mode. With async, only schedule the write.
+template <class T, class Dimv>
+void
+sync(Array<mmap_store<T>, Dimv> const & a, bool async=false)
+{
+    if (a.store.base) {
+        if (0!=::msync(a.store.base, a.store.bytes, async ? MS_ASYNC : MS_SYNC)) {
+            mmap_fail("msync", "mapping");
+        }
+    }
+}
+
+} // namespace ra
@@ -7,168 +7,2300 @@
 // Software Foundation; either version 3 of the License, or (at your option) any
 // later version.
 
-// TODO Parametrize traversal order, some ops (eg output, ravel) require specific orders.
-// TODO Better traversal. Tiling, etc. (see eval.cc in Blitz++). Unit step case?
-// TODO std::execution::xxx-policy TODO Validate output argument strides.
+// TODO Better traversal.
+// TODO Validate output argument strides.
 
 #pragma once
 #include "expr.hh"
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <condition_variable>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef RA_EXPLAIN
+#include <iostream>
+#endif
+
+#ifndef RA_INSTRUMENT
+#define RA_INSTRUMENT 0
+#endif
+#ifndef RA_PREFETCH
+#define RA_PREFETCH 16
+#endif
+#ifndef RA_TILE_BYTES
+#define RA_TILE_BYTES (1<<15)
+#endif
+#if RA_INSTRUMENT
+#include <map>
+#include <chrono>
+#endif
 
 namespace ra {
 
-// run time order/rank.
+// --------------------
+// Instrumentation. With RA_INSTRUMENT=1, traversals and allocations are counted per callsite.
+// The library can't see past its own entry points, so the callsite is that of the innermost ra::callsite on this thread.
+// --------------------
+
+#if RA_INSTRUMENT
+
+struct site_stats
+{
+    std::string_view kind;
+    std::source_location loc;
+    dim_t calls=0, elements=0, bytes=0, planned=0, inner=0, raveled=0;
+    double seconds=0;
+};
+
+struct Instrument
+{
+    using key_t = std::tuple<std::string_view, std::string_view, unsigned, unsigned>;
+    std::mutex m;
+    std::map<key_t, site_stats> s;
+    inline static thread_local std::source_location site {};
+
+    void
+    add(std::string_view kind, dim_t elements, dim_t bytes, dim_t inner, int raveled, double seconds)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        auto & t = s[{kind, site.file_name(), site.line(), site.column()}];
+        t.kind = kind;
+        t.loc = site;
+        ++t.calls;
+        t.elements += elements;
+        t.bytes += bytes;
+        if (raveled>=0) {
+            ++t.planned;
+            t.inner += inner;
+            t.raveled += raveled;
+        }
+        t.seconds += seconds;
+    }
+};
+
+inline Instrument instrument;
+
+struct callsite
+{
+    std::source_location prev;
+    explicit callsite(std::source_location loc = std::source_location::current()): prev(Instrument::site) { Instrument::site = loc; }
+    ~callsite() { Instrument::site = prev; }
+    callsite(callsite const &) = delete;
+    callsite & operator=(callsite const &) = delete;
+};
+
+struct instrument_probe
+{
+    std::string_view kind;
+    dim_t elements, bytes, inner = 0;
+    int raveled = -1; // -1 if no plan
+    std::chrono::steady_clock::time_point t0 {};
+
+    constexpr instrument_probe(std::string_view kind_, dim_t elements_, dim_t bytes_=0): kind(kind_), elements(elements_), bytes(bytes_)
+    {
+        if !consteval { t0 = std::chrono::steady_clock::now(); }
+    }
+    constexpr void plan(dim_t inner_, bool raveled_) { inner = inner_; raveled = raveled_; }
+    constexpr ~instrument_probe()
+    {
+        if !consteval {
+            instrument.add(kind, elements, bytes, inner, raveled,
+                           std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count());
+        }
+    }
+};
+
+// Hottest callsites first.
+inline std::vector<site_stats>
+instrument_snapshot()
+{
+    std::vector<site_stats> v;
+    {
+        std::lock_guard<std::mutex> lock(instrument.m);
+        for (auto const & [k, t]: instrument.s) { v.push_back(t); }
+    }
+    std::ranges::stable_sort(v, std::ranges::greater {}, &site_stats::seconds);
+    return v;
+}
+
+inline void
+instrument_reset()
+{
+    std::lock_guard<std::mutex> lock(instrument.m);
+    instrument.s.clear();
+}
+
+inline std::ostream &
+instrument_dump(std::ostream & o, int top=20)
+{
+    std::print(o, "{:>10} {:>8} {:>12} {:>12} {:>9} {:>6}  {:<10} {}\n", "seconds", "calls", "elements", "bytes", "inner", "ravel", "kind", "site");
+    for (auto const & t: instrument_snapshot() | std::views::take(top)) {
+        std::print(o, "{:10.6f} {:8} {:12} {:12} ", t.seconds, t.calls, t.elements, t.bytes);
+        if (t.planned>0) {
+            std::print(o, "{:9.1f} {:5.0f}%", double(t.inner)/t.planned, 100.*t.raveled/t.planned);
+        } else {
+            std::print(o, "{:>9} {:>6}", "-", "-");
+        }
+        std::print(o, "  {:<10} ", t.kind);
+        if (0==t.loc.line()) { o << "?\n"; } else { o << t.loc << "\n"; }
+    }
+    return o;
+}
+
+#define RA_PROBE(...) ra::instrument_probe ra_probe(__VA_ARGS__)
+#define RA_PROBE_PLAN(...) ra_probe.plan(__VA_ARGS__)
+#else
+#define RA_PROBE(...)
+#define RA_PROBE_PLAN(...)
+#endif
+
+// --------------------
+// Thread pool. Each worker owns a deque. Workers pop from the back of their own deque and steal from the front of the others'.
+// Tasks submitted from outside the pool go to an extra deque that every worker steals from. Pinned tasks go to a separate queue
+// that only its owner takes from.
+// --------------------
+
+// Limit on the number of threads for parallel regions started from this thread, 0 for none. Tasks run with limit 1 so that nested regions don't oversubscribe.
+inline thread_local int par_limit = 0;
+
+struct Pool
+{
+    struct Job
+    {
+        void (*run)(void *, int);
+        void * f;
+        std::atomic<int> pending;
+        std::vector<std::exception_ptr> err;
+    };
+    struct Task { Job * job; int t; };
+    struct Deque { std::mutex m; std::deque<Task> q, own; std::atomic<int> npin = 0; };
+
+    inline static thread_local int self = -1; // index of deque owned by this thread, -1 if not a worker.
+
+    std::vector<std::unique_ptr<Deque>> q;
+    std::mutex m;
+    std::condition_variable_any cv;
+    std::atomic<int> queued = 0;
+    std::vector<std::jthread> w; // destroy first.
+
+    explicit Pool(int nthreads) { start(nthreads); }
+    Pool(Pool const &) = delete;
+    Pool & operator=(Pool const &) = delete;
+
+    int nthreads() const { return int(w.size())+1; }
+
+    void
+    start(int nthreads)
+    {
+        int nw = std::max(1, nthreads>0 ? nthreads : int(std::thread::hardware_concurrency()))-1;
+        q.clear();
+        for (int i=0; i<=nw; ++i) { q.push_back(std::make_unique<Deque>()); }
+        for (int i=0; i<nw; ++i) { w.emplace_back([this, i](std::stop_token st){ work(st, i); }); }
+    }
+// not while any jobs are running.
+    void
+    stop()
+    {
+        for (auto & t: w) { t.request_stop(); }
+        cv.notify_all();
+        w.clear();
+    }
+    void
+    push(int i, Task k)
+    {
+        {
+            std::scoped_lock l(q[i]->m);
+            q[i]->q.push_back(k);
+        }
+        {
+            std::scoped_lock l(m);
+            ++queued;
+        }
+        cv.notify_one();
+    }
+    void
+    push_own(int i, Task k)
+    {
+        {
+            std::scoped_lock l(q[i]->m);
+            q[i]->own.push_back(k);
+        }
+        {
+            std::scoped_lock l(m);
+            ++q[i]->npin;
+        }
+        cv.notify_all();
+    }
+    bool
+    take(int i, Task & k)
+    {
+        if (Deque & d = *q[i]; d.npin>0) {
+            std::scoped_lock l(d.m);
+            if (!d.own.empty()) {
+                k = d.own.front(); d.own.pop_front();
+                --d.npin;
+                return true;
+            }
+        }
+        int n = q.size();
+        for (int j=0; j<n; ++j) {
+            Deque & d = *q[(i+j) % n];
+            std::scoped_lock l(d.m);
+            if (!d.q.empty()) {
+                if (0==j) { k = d.q.back(); d.q.pop_back(); } else { k = d.q.front(); d.q.pop_front(); }
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
+    static void
+    exec(Task const & k)
+    {
+        int limit = std::exchange(par_limit, 1);
+        try { k.job->run(k.job->f, k.t); } catch (...) { k.job->err[k.t] = std::current_exception(); }
+        par_limit = limit;
+        k.job->pending.fetch_sub(1, std::memory_order_release); // k.job may be gone after this
+    }
+    void
+    work(std::stop_token st, int i)
+    {
+        self = i;
+        while (!st.stop_requested()) {
+            if (Task k; take(i, k)) {
+                exec(k);
+            } else {
+                std::unique_lock l(m);
+                cv.wait(l, st, [this, i]{ return queued>0 || q[i]->npin>0; });
+            }
+        }
+    }
+// Run f(t) for 0<=t<nt. t=0 runs on the calling thread, which then helps until all the tasks are done. With pin, t>0 runs on
+// worker (t-1) % (number of workers), so the same t always goes to the same thread.
+    void
+    run(int nt, auto && f, bool pin=false)
+    {
+        using F = std::remove_reference_t<decltype(f)>;
+        Job job { .run=[](void * f, int t){ (*static_cast<F *>(f))(t); }, .f=(void *)(&f), .pending=nt, .err=std::vector<std::exception_ptr>(nt) };
+        int i = (self>=0 && self<int(q.size())-1) ? self : int(q.size())-1;
+        int nw = w.size();
+        for (int t=nt-1; t>0; --t) {
+            if (pin && nw>0) { push_own((t-1) % nw, { &job, t }); } else { push(i, { &job, t }); }
+        }
+        exec({ &job, 0 });
+        while (job.pending.load(std::memory_order_acquire)>0) {
+            if (Task k; take(i, k)) { exec(k); } else { std::this_thread::yield(); }
+        }
+        for (auto & e: job.err) {
+            if (e) { std::rethrow_exception(e); }
+        }
+    }
+};
+
+inline Pool &
+pool()
+{
+    static Pool p(0);
+    return p;
+}
+
+// n<=0: all available. Not while any parallel region is running.
+inline void
+set_num_threads(int n)
+{
+    pool().stop();
+    pool().start(n);
+}
+
+inline int get_num_threads() { return pool().nthreads(); }
+
+// Limit the number of threads for parallel regions started from this thread, within this scope.
+struct num_threads_scope
+{
+    int limit;
+    explicit num_threads_scope(int n): limit(std::exchange(par_limit, n)) {}
+    ~num_threads_scope() { par_limit = limit; }
+    num_threads_scope(num_threads_scope const &) = delete;
+    num_threads_scope & operator=(num_threads_scope const &) = delete;
+};
+
+// Execution policy. The outermost loop of the traversal is split in chunks of at least grain elements each. With pin, chunk t
+// always runs on the same thread, without stealing, cf init_par.
+
+struct par_t
+{
+    int nthreads = 0; // <=0: as many as the pool has.
+    dim_t grain = 1<<15;
+    bool pin = false;
+};
+
+constexpr par_t seq = { .nthreads=1 };
+constexpr par_t par = {};
+
+// Policy for the assignment operators, see ply_assign().
+inline thread_local par_t assign_par = seq;
+// Policy for the first fill of new arrays, see Array(s, x). The fill is always pinned. The pages of a new array end up next to the
+// threads that touch them first, so later traversals that are also pinned and split the same way work on local memory.
+inline thread_local par_t init_par = seq;
+
+inline int
+par_nthreads(par_t const & p, dim_t size, dim_t len)
+{
+    if (1==p.nthreads || 1==par_limit) {
+        return 1;
+    }
+    dim_t nt = p.nthreads>0 ? dim_t(p.nthreads) : dim_t(get_num_threads());
+    if (par_limit>0) {
+        nt = std::min(nt, dim_t(par_limit));
+    }
+    return int(std::max(dim_t(1), std::min({nt, len, size/std::max(dim_t(1), p.grain)})));
+}
+
+// Static partition. Chunk t of nt is [par_begin(n, t, nt), par_begin(n, t+1, nt)).
+constexpr dim_t par_begin(dim_t n, int t, int nt) { return n*t/nt; }
+
+// Run f(t) for 0<=t<nt. Rethrow the first exception, if any.
+inline void
+par_run(int nt, auto && f, bool pin=false)
+{
+    if (1==nt) {
+        int limit = std::exchange(par_limit, 1);
+        try { f(0); } catch (...) { par_limit = limit; throw; }
+        par_limit = limit;
+    } else {
+        pool().run(nt, f, pin);
+    }
+}
+
+// Traversal order. By default (none) the order is chosen from the steps of the expression, but traversal with early exit is always row-major.
+// An explicit order ilist<i ...> goes from outer to inner axis.
+
+constexpr struct rowmajor_t {} rowmajor;
+
+template <int ... i>
+constexpr bool is_order = []{
+    std::array<int, sizeof...(i)> o = { i ... };
+    std::ranges::sort(o);
+    for (int k=0; k<int(sizeof...(i)); ++k) { if (o[k]!=k) return false; }
+    return true;
+}();
+
+// Total |step| of all the leaves, for the axis order planner.
+constexpr dim_t
+step_cost(auto const & s)
+{
+    if constexpr (requires { []<class ... T>(std::tuple<T ...> const &){}(s); }) {
+        return std::apply([](auto const & ... s){ return (dim_t(0) + ... + step_cost(s)); }, s);
+    } else {
+        return s<0 ? -dim_t(s) : dim_t(s);
+    }
+}
+
+// Unit step path. If every leaf that moves has step 1 on the inner axis, mov(unitstep) can replace mov(step), and the compiler can see the step.
+
+template <class S> constexpr auto unitstep = ic<1>;
+template <class ... S> constexpr auto unitstep<std::tuple<S ...>> = std::make_tuple(unitstep<S> ...);
+
+constexpr bool
+all_unit(auto const & s)
+{
+    if constexpr (requires { []<class ... T>(std::tuple<T ...> const &){}(s); }) {
+        return std::apply([](auto const & ... s){ return (all_unit(s) && ...); }, s);
+    } else {
+        return 1==s;
+    }
+}
+
+// Scalar ignores mov. Other leaves with step 0 (e.g. dead axes of Reframe) don't.
+constexpr bool
+unit_step(auto const & a, rank_t k)
+{
+    if constexpr (requires { []<class C>(Scalar<C> const &){}(a); }) {
+        return true;
+    } else if constexpr (requires { []<class ... P>(Match<std::tuple<P ...>> const &){}(a); }) {
+        return std::apply([&k](auto const & ... p){ return (unit_step(p, k) && ...); }, a.t);
+    } else {
+        return all_unit(a.step(k));
+    }
+}
+
+// Sort axes by step cost, inner first. Ties are left in row-major order.
+constexpr void
+ply_sort(auto const & cost, auto && order, rank_t rank)
+{
+    for (rank_t i=0; i<rank; ++i) {
+        rank_t k = rank-1-i, j = i;
+        for (; j>0 && cost(k)<cost(order(j-1)); --j) {
+            order(j) = order(j-1);
+        }
+        order(j) = k;
+    }
+}
+
+// run time order/rank.
+
+struct ply_axis { rank_t order; dim_t len, ind=0; };
+
+// Inline for small rank, to avoid allocation or TLS in ply_ravel.
+struct ply_axes
+{
+    constexpr static rank_t N = 8;
+    ply_axis zs[N];
+    std::unique_ptr<ply_axis []> zh;
+    ply_axis * z;
+    constexpr explicit ply_axes(rank_t rank): z(rank<=N ? zs : (zh = std::make_unique<ply_axis []>(rank)).get()) {}
+    ply_axes(ply_axes const &) = delete;
+    ply_axes & operator=(ply_axes const &) = delete;
+    constexpr ply_axis * data() { return z; }
+    constexpr ply_axis & operator[](rank_t k) { return z[k]; }
+};
+
+// z[0] is the inner loop, z[rank-1] the outer loop.
+template <class Order = none_t>
+constexpr void
+ply_order(Iterator auto const & a, ply_axis * z, rank_t rank, Order const & order = none)
+{
+    if constexpr (std::is_same_v<Order, none_t>) {
+        ply_sort([&a](rank_t k){ return step_cost(a.step(k)); }, [z](int i) -> rank_t & { return z[i].order; }, rank);
+    } else if constexpr (std::is_same_v<Order, rowmajor_t>) {
+        for (rank_t i=0; i<rank; ++i) { z[i].order = rank-1-i; }
+    } else {
+        [&]<int ... i>(ilist_t<i ...>){
+            static_assert(is_order<i ...>, "Bad traversal order.");
+            RA_CK(int(sizeof...(i))==rank, "Bad traversal order for rank ", rank, ".");
+            std::array<rank_t, sizeof...(i)> o = { i ... };
+            for (rank_t j=0; j<rank; ++j) { z[j].order = o[rank-1-j]; }
+        }(order);
+    }
+    for (rank_t i=0; i<rank; ++i) {
+        z[i].len = a.len(z[i].order);
+        z[i].ind = 0;
+    }
+}
+
+// z[0] is the inner loop and takes up as many compact axes as possible. z[1 ... n] are the outer loops. Return n.
+template <class Order = none_t>
+constexpr rank_t
+ply_plan(Iterator auto const & a, ply_axis * z, rank_t rank, Order const & order = none)
+{
+    ply_order(a, z, rank, order);
+// find outermost compact dim.
+    rank_t k = 1;
+    for (; k<rank && a.keep(z[0].len, z[0].order, z[k].order); ++k) {
+        z[0].len *= z[k].len;
+    }
+    for (rank_t j=k; j<rank; ++j) {
+        z[j-k+1] = z[j];
+    }
+    return rank-k;
+}
+
+template <class Early>
+constexpr auto
+ply_loop(Iterator auto & a, ply_axis * z, rank_t n, auto const & ss0, Early const & early)
+{
+    for (;;) {
+        auto place = a.save();
+        for (dim_t s=z[0].len; --s>=0; a.mov(ss0)) {
+            if constexpr (requires { none_t(early); }) {
+                *a;
+            } else {
+                if (auto stop = *a) {
+                    return stop.value();
+                }
+            }
+        }
+        a.load(place); // FIXME wasted if k=0. Cf test/iota.cc
+        for (int k=1; ; ++k) {
+            if (k>n) {
+                if constexpr (requires { none_t(early); }) {
+                    return;
+                } else {
+                    return early;
+                }
+            } else if (++z[k].ind<z[k].len) {
+                a.adv(z[k].order, 1);
+                break;
+            } else {
+                z[k].ind = 0;
+                a.adv(z[k].order, 1-z[k].len);
+            }
+        }
+    }
+}
+
+// Loop nest for fixed n, cf subply.
+template <int k, class Early>
+constexpr auto
+ply_nest(Iterator auto & a, ply_axis const * z, auto const & ss0, Early const & early)
+{
+    if constexpr (0==k) {
+        auto place = a.save();
+        for (dim_t s=z[0].len; --s>=0; a.mov(ss0)) {
+            if constexpr (requires { none_t(early); }) {
+                *a;
+            } else {
+                if (auto stop = *a) {
+                    return stop;
+                }
+            }
+        }
+        a.load(place);
+    } else {
+        for (dim_t i=z[k].len; --i>=0; a.adv(z[k].order, 1)) {
+            if constexpr (requires { none_t(early); }) {
+                ply_nest<k-1>(a, z, ss0, early);
+            } else {
+                if (auto stop = ply_nest<k-1>(a, z, ss0, early)) {
+                    return stop;
+                }
+            }
+        }
+        a.adv(z[k].order, -z[k].len);
+    }
+    if constexpr (requires { none_t(early); }) {
+        return;
+    } else {
+        return static_cast<decltype(*a)>(std::nullopt);
+    }
+}
+
+template <class Early>
+constexpr auto
+ply_run(Iterator auto & a, ply_axis * z, rank_t n, auto const & ss0, Early const & early)
+{
+    auto nest = [&](auto k){
+        if constexpr (requires { none_t(early); }) {
+            ply_nest<k>(a, z, ss0, early);
+        } else {
+            return ply_nest<k>(a, z, ss0, early).value_or(early);
+        }
+    };
+    switch (n) {
+    case 0: return nest(ic<0>);
+    case 1: return nest(ic<1>);
+    case 2: return nest(ic<2>);
+    case 3: return nest(ic<3>);
+    default: return ply_loop(a, z, n, ss0, early);
+    }
+}
+
+template <class Early = none_t, class Order = none_t>
+constexpr auto
+ply_ravel(Iterator auto && a, Early const & early = none, Order const & order = none)
+{
+    validate(a);
+    RA_PROBE("ply_ravel", ra::size(a));
+    rank_t rank = ra::rank(a);
+    if (0==rank) {
+        if constexpr (requires { none_t(early); }) {
+            *a; return;
+        } else {
+            return (*a).value_or(early);
+        }
+    }
+    ply_axes z(rank);
+    rank_t n = [&]{
+        if constexpr (std::is_same_v<Order, none_t> && !std::is_same_v<Early, none_t>) {
+            return ply_plan(a, z.data(), rank, rowmajor);
+        } else {
+            return ply_plan(a, z.data(), rank, order);
+        }
+    }();
+    RA_PROBE_PLAN(z[0].len, 0==n);
+    for (int k=0; k<=n; ++k) {
+        if (0>=z[k].len) {
+            if constexpr (requires { none_t(early); }) {
+                return;
+            } else {
+                return early;
+            }
+        }
+    }
+    if (unit_step(a, z[0].order)) {
+        return ply_run(a, z.data(), n, unitstep<decltype(a.step(0))>, early);
+    } else {
+        return ply_run(a, z.data(), n, a.step(z[0].order), early);
+    }
+}
+
+// Split the outermost loop, which is the inner loop if all the axes could be raveled. fix(ta, t) prepares the copy of a for chunk t.
+inline void
+ply_ravel(par_t const & p, Iterator auto && a, auto && fix)
+{
+    validate(a);
+    RA_PROBE("ply_par", ra::size(a));
+    rank_t rank = ra::rank(a);
+    if (0==rank) {
+        fix(a, 0); *a; return;
+    }
+    ply_axes z(rank);
+    rank_t n = ply_plan(a, z.data(), rank);
+    RA_PROBE_PLAN(z[0].len, 0==n);
+    dim_t size = 1;
+    for (int k=0; k<=n; ++k) {
+        if (0>=z[k].len) {
+            return;
+        }
+        size *= z[k].len;
+    }
+    auto run = [&](auto const & ss0){
+        if (int nt=par_nthreads(p, size, z[n].len); 1==nt) {
+            fix(a, 0);
+            ply_run(a, z.data(), n, ss0, none);
+        } else {
+            par_run(nt, [&](int t){
+                ply_axes zt(n+1);
+                std::copy(z.data(), z.data()+n+1, zt.data());
+                dim_t i0 = par_begin(z[n].len, t, nt), i1 = par_begin(z[n].len, t+1, nt);
+                auto ta = a;
+                fix(ta, t);
+                ta.adv(zt[n].order, i0);
+                zt[n].len = i1-i0;
+                ply_run(ta, zt.data(), n, ss0, none);
+            }, p.pin);
+        }
+    };
+    if (unit_step(a, z[0].order)) {
+        run(unitstep<decltype(a.step(0))>);
+    } else {
+        run(a.step(z[0].order));
+    }
+}
+
+// compile time order/rank.
+
+template <auto order, int k, int urank, class S, class Early>
+constexpr auto
+subply(Iterator auto & a, dim_t s, S const & ss0, Early const & early)
+{
+    if constexpr (k < urank) {
+        auto place = a.save();
+        for (; --s>=0; a.mov(ss0)) {
+            if constexpr (requires { none_t(early); }) {
+                *a;
+            } else {
+                if (auto stop = *a) {
+                    return stop;
+                }
+            }
+        }
+        a.load(place); // FIXME wasted if k was 0 at the top
+    } else {
+        constexpr dim_t size = std::decay_t<decltype(a)>::len_s(order[k]);
+        for (dim_t i=0; i<size; ++i) {
+            if constexpr (requires { none_t(early); }) {
+                subply<order, k-1, urank>(a, s, ss0, early);
+            } else {
+                if (auto stop = subply<order, k-1, urank>(a, s, ss0, early)) {
+                    return stop;
+                }
+            }
+            a.adv(order[k], 1);
+        }
+        a.adv(order[k], -size);
+    }
+    if constexpr (requires { none_t(early); }) {
+        return;
+    } else {
+        return static_cast<decltype(*a)>(std::nullopt);
+    }
+}
+
+// Fully unrolled subply, for small sizes. s is the length of the inner loop.
+template <auto order, int k, int urank, dim_t s>
+constexpr void
+subply_unrolled(Iterator auto & a, auto const & ss0)
+{
+    if constexpr (k < urank) {
+        auto place = a.save();
+        [&]<int ... i>(ilist_t<i ...>){ ((void(*a), a.mov(ss0)), ...); }(mp::iota<int(s)> {});
+        a.load(place);
+    } else {
+        constexpr dim_t size = std::decay_t<decltype(a)>::len_s(order[k]);
+        [&]<int ... i>(ilist_t<i ...>){ ((subply_unrolled<order, k-1, urank, s>(a, ss0), a.adv(order[k], 1)), ...); }(mp::iota<int(size)> {});
+        a.adv(order[k], -size);
+    }
+}
+
+// Maximum size_s for full unrolling in ply_fixed.
+#ifndef RA_UNROLL
+#define RA_UNROLL 32
+#endif
+
+// inner first. The automatic order needs static steps, otherwise use row-major.
+template <class A, class Early, class Order>
+consteval auto
+ply_order_s()
+{
+    constexpr rank_t rank = rank_s<A>();
+    std::array<int, rank> o {};
+    if constexpr (std::is_same_v<Order, none_t> && std::is_same_v<Early, none_t> && requires { A::step(0); }) {
+        ply_sort([](rank_t k){ return step_cost(A::step(k)); }, [&o](int i) -> int & { return o[i]; }, rank);
+    } else if constexpr (std::is_same_v<Order, none_t> || std::is_same_v<Order, rowmajor_t>) {
+        for (rank_t i=0; i<rank; ++i) { o[i] = rank-1-i; }
+    } else {
+        []<int ... i>(ilist_t<i ...>, auto & o){
+            static_assert(is_order<i ...> && rank==sizeof...(i), "Bad traversal order.");
+            std::array<int, sizeof...(i)> oi = { i ... };
+            for (rank_t j=0; j<rank; ++j) { o[j] = oi[rank-1-j]; }
+        }(Order {}, o);
+    }
+    return o;
+}
+
+// Steps known to be 1 at compile time.
+template <class A, int k>
+constexpr bool ply_unit_s = [] {
+    if constexpr (requires { A::step(k); }) {
+        return all_unit(A::step(k));
+    } else {
+        return false;
+    }
+}();
+
+// Like ply_plan, ravel as many axes as possible into the inner loop, if that can be decided at compile time.
+// Return the number of raveled axes and the length of the inner loop.
+template <class A, auto order>
+constexpr auto ply_ravel_s = [] {
+    constexpr rank_t rank = rank_s<A>();
+    rank_t k = 1;
+    dim_t s = A::len_s(order[0]);
+    if constexpr (requires { A::keep(dim_t(0), 0, 0); }) {
+        for (; k<rank && A::keep(s, order[0], order[k]); ++k) {
+            s *= A::len_s(order[k]);
+        }
+    }
+    return std::pair<rank_t, dim_t>(k, s);
+}();
+
+template <class Early = none_t, class Order = none_t>
+constexpr auto
+ply_fixed(Iterator auto && a, Early const & early = none, Order const & = none)
+{
+    validate(a);
+    RA_PROBE("ply_fixed", size_s(a));
+    constexpr rank_t rank = rank_s(a);
+    static_assert(0<=rank, "ply_fixed requires static rank");
+    if constexpr (0==rank) {
+        if constexpr (requires { none_t(early); }) {
+            *a; return;
+        } else {
+            return (*a).value_or(early);
+        }
+    } else {
+        using A = std::decay_t<decltype(a)>;
+        constexpr auto order = ply_order_s<A, Early, Order>();
+        constexpr auto rs = ply_ravel_s<A, order>;
+        RA_PROBE_PLAN(rs.second, rank==rs.first);
+        auto run = [&](auto const & ss0){
+            if constexpr (requires { none_t(early); }) {
+                if constexpr (size_s<A>()<=RA_UNROLL) {
+                    subply_unrolled<order, rank-1, rs.first, rs.second>(a, ss0);
+                } else {
+                    subply<order, rank-1, rs.first>(a, rs.second, ss0, early);
+                }
+            } else {
+                return (subply<order, rank-1, rs.first>(a, rs.second, ss0, early)).value_or(early);
+            }
+        };
+        if constexpr (ply_unit_s<std::decay_t<decltype(a)>, order[0]>) {
+            return run(unitstep<decltype(a.step(0))>);
+        } else if (unit_step(a, order[0])) {
+            return run(unitstep<decltype(a.step(0))>);
+        } else {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic warning "-Warray-bounds"
+            return run(a.step(order[0])); // gcc 14.1 with RA_CHECK=0 and sanitizer on
+#pragma GCC diagnostic pop
+        }
+    }
+}
+
+inline void
+ply_fixed(par_t const & p, Iterator auto && a, auto && fix)
+{
+    validate(a);
+    constexpr rank_t rank = rank_s(a);
+    static_assert(0<=rank, "ply_fixed requires static rank");
+    if constexpr (0==rank) {
+        fix(a, 0); *a;
+    } else {
+        constexpr auto order = ply_order_s<std::decay_t<decltype(a)>, none_t, none_t>();
+        dim_t const len = a.len(order[rank-1]);
+        if (int nt=par_nthreads(p, ra::size(a), len); 1==nt) {
+            fix(a, 0);
+            ply_fixed(RA_FW(a));
+        } else {
+            RA_PROBE("ply_par", size_s(a));
+            auto run = [&](auto const & ss0){
+                par_run(nt, [&](int t){
+                    dim_t i0 = par_begin(len, t, nt), i1 = par_begin(len, t+1, nt);
+                    auto ta = a;
+                    fix(ta, t);
+                    ta.adv(order[rank-1], i0);
+                    if constexpr (1==rank) {
+                        subply<order, 0, 1>(ta, i1-i0, ss0, none);
+                    } else {
+                        for (dim_t i=i0; i<i1; ++i) {
+                            subply<order, rank-2, 1>(ta, ta.len(order[0]), ss0, none);
+                            ta.adv(order[rank-1], 1);
+                        }
+                    }
+                }, p.pin);
+            };
+            if (ply_unit_s<std::decay_t<decltype(a)>, order[0]> || unit_step(a, order[0])) {
+                run(unitstep<decltype(a.step(0))>);
+            } else {
+                run(a.step(order[0]));
+            }
+        }
+    }
+}
+
+template <class A> concept is_cell = requires (A a) { []<class P, class D, class C>(Cell<P, D, C> const &){}(a); };
+template <class A> concept is_reframe = requires (A a) { []<class B, class D, class I>(Reframe<B, D, I> const &){}(a); };
+
+// Tiled traversal of the two inner axes, for expressions where the steps of different leaves favor different orders.
+
+struct tile_t
+{
+    dim_t outer = 0, inner = 0; // <=0: automatic.
+};
+
+// Bytes per element over the leaves of A that are in memory.
+template <class A>
+constexpr dim_t tile_bytes = [] {
+    if constexpr (is_match<A>) {
+        return []<class ... P>(std::tuple<P ...> const *){ return (dim_t(0) + ... + tile_bytes<std::decay_t<P>>); }((decltype(A::t) *)nullptr);
+    } else if constexpr (is_reframe<A>) {
+        return tile_bytes<std::decay_t<decltype(A::a)>>;
+    } else if constexpr (is_cell<A> && std::is_pointer_v<decltype(A::c.cp)>) {
+        return dim_t(sizeof(*A::c.cp));
+    } else {
+        return dim_t(0);
+    }
+}();
+
+// Default tile side, a power of 2 such that a square tile of every leaf fits in RA_TILE_BYTES.
+template <class A>
+constexpr dim_t tile_side = [] {
+    dim_t n = RA_TILE_BYTES/std::max(dim_t(1), tile_bytes<A>), t = 8;
+    for (; t<256 && 4*t*t<=n; t*=2) {}
+    return t;
+}();
+
+// True if any leaf has a larger step on the inner axis than on the outer one.
+constexpr bool
+tile_mismatch(auto const & s0, auto const & s1)
+{
+    if constexpr (requires { []<class ... T>(std::tuple<T ...> const &){}(s0); }) {
+        return [&]<int ... i>(ilist_t<i ...>){ return (tile_mismatch(get<i>(s0), get<i>(s1)) || ...); }
+            (mp::iota<std::tuple_size_v<std::decay_t<decltype(s0)>>> {});
+    } else {
+        return 0!=s1 && step_cost(s1)<step_cost(s0);
+    }
+}
+
+inline void
+ply_tiled(tile_t const & t, Iterator auto && a)
+{
+    validate(a);
+    rank_t rank = ra::rank(a);
+    if (2>rank) {
+        return ply(RA_FW(a));
+    }
+    ply_axes z(rank);
+    ply_order(a, z.data(), rank);
+    for (int k=0; k<rank; ++k) {
+        if (0>=z[k].len) {
+            return;
+        }
+    }
+    rank_t i0 = z[0].order, i1 = z[1].order;
+    dim_t l0 = z[0].len, l1 = z[1].len;
+    auto s0 = a.step(i0);
+    if (t.inner<=0 && t.outer<=0 && !tile_mismatch(s0, a.step(i1))) {
+        return ply(RA_FW(a));
+    }
+    RA_PROBE("ply_tiled", ra::size(a));
+    constexpr dim_t tdef = tile_side<std::decay_t<decltype(a)>>;
+    dim_t t0 = t.inner>0 ? t.inner : tdef, t1 = t.outer>0 ? t.outer : tdef;
+    for (;;) {
+        for (dim_t b1=0; b1<l1; b1+=t1) {
+            dim_t n1 = std::min(t1, l1-b1);
+            for (dim_t b0=0; b0<l0; b0+=t0) {
+                dim_t n0 = std::min(t0, l0-b0);
+                for (dim_t j1=0; j1<n1; ++j1) {
+                    auto place = a.save();
+                    for (dim_t j0=n0; --j0>=0; a.mov(s0)) {
+                        *a;
+                    }
+                    a.load(place);
+                    a.adv(i1, 1);
+                }
+                a.adv(i1, -n1);
+                a.adv(i0, n0);
+            }
+            a.adv(i0, -l0);
+            a.adv(i1, n1);
+        }
+        a.adv(i1, -l1);
+        for (int k=2; ; ++k) {
+            if (k>=rank) {
+                return;
+            } else if (++z[k].ind<z[k].len) {
+                a.adv(z[k].order, 1);
+                break;
+            } else {
+                z[k].ind = 0;
+                a.adv(z[k].order, 1-z[k].len);
+            }
+        }
+    }
+}
+
+// OpenMP traversal. The outermost loop is a canonical loop over dim_t, and each iteration places its own copy of the expression with
+// adv(), so no iterator state is carried between iterations. Inside a parallel region this is an orphaned omp for, to be reached by
+// all the threads of the team. Without _OPENMP it's serial.
+
+struct omp_t
+{
+    dim_t block = 1<<12; // split of the inner loop when all the axes could be raveled.
+};
+
+constexpr omp_t omp {};
+
+// Only one thread of a team counts the elements, cf RA_PROBE.
+inline bool
+omp_lead()
+{
+#ifdef _OPENMP
+    return 0==omp_get_thread_num();
+#else
+    return true;
+#endif
+}
+
+inline void
+ply_omp(omp_t const & p, Iterator auto && a)
+{
+    validate(a);
+    RA_PROBE("ply_omp", omp_lead() ? ra::size(a) : 0);
+    rank_t rank = ra::rank(a);
+    if (0==rank) {
+        *a; return;
+    }
+    ply_axes z(rank);
+    rank_t n = ply_plan(a, z.data(), rank);
+    RA_PROBE_PLAN(z[0].len, 0==n);
+    for (int k=0; k<=n; ++k) {
+        if (0>=z[k].len) {
+            return;
+        }
+    }
+    dim_t const len = z[n].len;
+    dim_t const bl = 0==n ? std::max(dim_t(1), std::min(len, p.block)) : 1;
+    dim_t const nb = (len+bl-1)/bl;
+// an orphaned call runs on every thread of the team, each with its own err. Errors go to the err of the thread that runs the
+// single, and every thread rethrows it, so the exception leaves the parallel region on all threads or none.
+    std::exception_ptr err, * perr = &err;
+#ifdef _OPENMP
+    bool const orphan = omp_in_parallel();
+    if (orphan) {
+#pragma omp single copyprivate(perr)
+        {}
+    }
+#endif
+    auto run = [&](auto const & ss0){
+        auto body = [&](dim_t i){
+            try {
+                ply_axes zt(n+1);
+                std::copy(z.data(), z.data()+n+1, zt.data());
+                zt[n].len = std::min(bl, len-i*bl);
+                auto ta = a;
+                ta.adv(z[n].order, i*bl);
+                ply_run(ta, zt.data(), n, ss0, none);
+            } catch (...) {
+#ifdef _OPENMP
+#pragma omp critical (ra_ply_omp)
+#endif
+                if (!*perr) { *perr = std::current_exception(); }
+            }
+        };
+#ifdef _OPENMP
+        if (orphan) {
+#pragma omp for
+            for (dim_t i=0; i<nb; ++i) { body(i); }
+        } else {
+#pragma omp parallel for
+            for (dim_t i=0; i<nb; ++i) { body(i); }
+        }
+#else
+        for (dim_t i=0; i<nb; ++i) { body(i); }
+#endif
+    };
+    if (unit_step(a, z[0].order)) {
+        run(unitstep<decltype(a.step(0))>);
+    } else {
+        run(a.step(z[0].order));
+    }
+#ifdef _OPENMP
+    if (orphan) {
+        std::exception_ptr e = *perr; // after the implicit barrier of omp for.
+#pragma omp barrier
+        err = e;
+    }
+#endif
+    if (err) {
+        std::rethrow_exception(err);
+    }
+}
+
+// defaults.
+
+template <class Early = none_t, class Order = none_t>
+constexpr auto
+ply(Iterator auto && a, Early const & early = none, Order const & order = none)
+{
+#ifdef RA_EXPLAIN
+    if !consteval {
+        if (ra::size(a)>=RA_EXPLAIN) {
+            if constexpr (std::is_same_v<Early, none_t>) {
+                ra::print(std::cerr, explain(a, order), "\n");
+            } else {
+// traversal with early exit is row major by default, and it isn't unrolled.
+                auto p = explain(a, [&]{ if constexpr (std::is_same_v<Order, none_t>) return rowmajor; else return order; }());
+                p.unroll = false;
+                ra::print(std::cerr, p, "\n");
+            }
+        }
+    }
+#endif
+    if constexpr (ANY==size_s(a)) {
+        return ply_ravel(RA_FW(a), early, order);
+    } else {
+        return ply_fixed(RA_FW(a), early, order);
+    }
+}
+
+inline void
+ply_par(par_t const & p, Iterator auto && a, auto && fix)
+{
+    if constexpr (ANY==size_s(a)) {
+        ply_ravel(p, RA_FW(a), fix);
+    } else {
+        ply_fixed(p, RA_FW(a), fix);
+    }
+}
+
+constexpr void
+ply(par_t const & p, Iterator auto && a)
+{
+    if consteval {
+        ply(RA_FW(a));
+    } else {
+        ply_par(p, RA_FW(a), [](auto &, int){});
+    }
+}
+
+constexpr void
+ply(tile_t const & t, Iterator auto && a)
+{
+    if consteval {
+        ply(RA_FW(a));
+    } else {
+        ply_tiled(t, RA_FW(a));
+    }
+}
+
+constexpr void
+ply(omp_t const & p, Iterator auto && a)
+{
+    if consteval {
+        ply(RA_FW(a));
+    } else {
+        ply_omp(p, RA_FW(a));
+    }
+}
+
+template <class P> concept is_ply_policy = std::is_same_v<P, par_t> || std::is_same_v<P, tile_t> || std::is_same_v<P, omp_t>;
+
+constexpr void for_each(auto && op, auto && ... a) requires (!is_ply_policy<std::decay_t<decltype(op)>>) { ply(map(RA_FW(op), RA_FW(a) ...)); }
+constexpr void for_each(is_ply_policy auto const & p, auto && op, auto && ... a) { ply(p, map(RA_FW(op), RA_FW(a) ...)); }
+constexpr auto early(Iterator auto && a, auto const & def) { return ply(RA_FW(a), def); }
+
+// Statement fusion. A statement is op(a ...) applied elementwise, as in for_each. fused() agrees the arguments of all the statements
+// and runs the statements in order for each element, in a single traversal.
+
+template <class Op, class ... A>
+struct Statement
+{
+    Op op;
+    std::tuple<A ...> a;
+};
+
+// Rvalue arguments are kept by value, so statements can be built ahead of fused().
+constexpr auto
+stmt(auto && op, auto && ... a)
+{
+    return Statement<std::decay_t<decltype(op)>, std::conditional_t<std::is_lvalue_reference_v<decltype(a)>, decltype(a), std::decay_t<decltype(a)>> ...>
+        { RA_FW(op), { RA_FW(a) ... } };
+}
+
+constexpr auto assign(auto && y, auto && x) { return stmt([](auto && y, auto && x){ RA_FW(y) = RA_FW(x); }, RA_FW(y), RA_FW(x)); }
+
+// Accumulate k(c, a ...) on c.
+template <class C, class K>
+constexpr auto
+reduce(C & c, K && k, auto && a0, auto && ... a)
+{
+    return stmt([&c, k=RA_FW(k)](auto && ... a){ k(c, RA_FW(a) ...); }, RA_FW(a0), RA_FW(a) ...);
+}
+
+template <class Op, class N> struct fused_op;
+
+template <class ... Op, int ... n>
+struct fused_op<std::tuple<Op ...>, ilist_t<n ...>>
+{
+    constexpr static std::array<int, sizeof...(n)> len = { n ... };
+    constexpr static std::array<int, sizeof...(n)> off = []{
+        std::array<int, sizeof...(n)> o {};
+        for (int i=1; i<int(sizeof...(n)); ++i) { o[i] = o[i-1]+len[i-1]; }
+        return o;
+    }();
+    std::tuple<Op ...> op;
+    template <int i, int ... j>
+    constexpr void
+    call(auto & args, ilist_t<j ...>) const
+    {
+        std::get<i>(op)(std::get<off[i]+j>(args) ...);
+    }
+    constexpr void
+    operator()(auto && ... a) const
+    {
+        auto args = std::forward_as_tuple(RA_FW(a) ...);
+        [&]<int ... i>(ilist_t<i ...>){ (call<i>(args, mp::iota<len[i]> {}), ...); }(mp::iota<sizeof...(n)> {});
+    }
+};
+
+template <class ... S>
+constexpr void
+fused(S && ... s)
+{
+    using F = fused_op<std::tuple<decltype(s.op) ...>, ilist_t<int(std::tuple_size_v<decltype(s.a)>) ...>>;
+    std::apply([&](auto && ... a){ ply(map(F { { RA_FW(s).op ... } }, RA_FW(a) ...)); }, std::tuple_cat(RA_FW(s).a ...));
+}
+
+// Early exit for boolean expressions. The elements are tested in blocks, each block without per-element checks, and the block is
+// rescanned only if it contains a match. Chunks stop when another chunk has found a match before them (first) or any match (!first).
+// Return the row-major position of the first match, or -1 if there's none. With !first, the position is of some match.
+
+constexpr dim_t find_block = 256;
+
+template <bool first>
+inline bool
+find_line(Iterator auto & a, dim_t len, auto const & ss0, dim_t i, std::atomic<dim_t> & found, dim_t nf)
+{
+    auto place = a.save();
+    for (dim_t b=0; b<len; b+=find_block) {
+        dim_t f = found.load(std::memory_order_relaxed);
+        if (first ? f<i+b : f!=nf) {
+            a.load(place);
+            return true;
+        }
+        dim_t nb = std::min(find_block, len-b);
+        auto pb = a.save();
+        bool hit = false;
+        for (dim_t j=0; j<nb; ++j, a.mov(ss0)) {
+            hit |= bool(*a);
+        }
+        if (hit) {
+            a.load(pb);
+            dim_t j = 0;
+            for (; !bool(*a); ++j, a.mov(ss0)) {}
+            for (dim_t x=i+b+j; x<f && !found.compare_exchange_weak(f, x, std::memory_order_relaxed); ) {}
+            a.load(place);
+            return true;
+        }
+    }
+    a.load(place);
+    return false;
+}
+
+template <bool first=true>
+inline dim_t
+ply_find(par_t const & p, Iterator auto && a)
+{
+    validate(a);
+    RA_PROBE("ply_find", ra::size(a));
+    rank_t rank = ra::rank(a);
+    if (0==rank) {
+        return bool(*a) ? 0 : -1;
+    }
+    ply_axes z(rank);
+    rank_t n = ply_plan(a, z.data(), rank, rowmajor);
+    RA_PROBE_PLAN(z[0].len, 0==n);
+    dim_t size = 1;
+    for (int k=0; k<=n; ++k) {
+        if (0>=z[k].len) {
+            return -1;
+        }
+        size *= z[k].len;
+    }
+    std::atomic<dim_t> found = size;
+    auto run = [&](auto const & ss0){
+        int nt = par_nthreads(p, size, z[n].len);
+        par_run(nt, [&](int t){
+            dim_t i0 = par_begin(z[n].len, t, nt), i1 = par_begin(z[n].len, t+1, nt);
+            auto ta = a;
+            ta.adv(z[n].order, i0);
+            if (0==n) {
+                find_line<first>(ta, i1-i0, ss0, i0, found, size);
+                return;
+            }
+            ply_axes zt(n+1);
+            std::copy(z.data(), z.data()+n+1, zt.data());
+            zt[n].len = i1-i0;
+            dim_t i = i0;
+            for (int k=0; k<n; ++k) { i *= z[k].len; }
+            for (;;) {
+                if (find_line<first>(ta, zt[0].len, ss0, i, found, size)) {
+                    return;
+                }
+                i += zt[0].len;
+                for (int k=1; ; ++k) {
+                    if (k>n) {
+                        return;
+                    } else if (++zt[k].ind<zt[k].len) {
+                        ta.adv(zt[k].order, 1);
+                        break;
+                    } else {
+                        zt[k].ind = 0;
+                        ta.adv(zt[k].order, 1-zt[k].len);
+                    }
+                }
+            }
+        });
+    };
+    if (unit_step(a, z[0].order)) {
+        run(unitstep<decltype(a.step(0))>);
+    } else {
+        run(a.step(z[0].order));
+    }
+    dim_t f = found.load();
+    return f==size ? -1 : f;
+}
+
+// Row major traversal of a over [i0, i1) along axis 0, for splitting in blocks. f(a, z) gets the position and z[k].ind its index.
+inline void
+ply_rows(Iterator auto & a, dim_t i0, dim_t i1, auto && f)
+{
+    rank_t rank = ra::rank(a), l = rank-1;
+    RA_CK(0<rank, "ply_rows needs rank > 0.");
+    ply_axes z(rank);
+    for (rank_t k=0; k<rank; ++k) {
+        z[k] = { .order=k, .len=(0==k ? i1 : dim_t(a.len(k))), .ind=(0==k ? i0 : 0) };
+        if (z[k].ind>=z[k].len) {
+            return;
+        }
+    }
+    a.adv(0, i0);
+    dim_t j0 = z[l].ind, n = z[l].len-j0;
+    for (;;) {
+        for (; z[l].ind<z[l].len; ++z[l].ind) {
+            f(a, z);
+            a.adv(l, 1);
+        }
+        a.adv(l, -n);
+        z[l].ind = j0;
+        for (rank_t k=l-1; ; --k) {
+            if (k<0) {
+                return;
+            } else if (++z[k].ind<z[k].len) {
+                a.adv(k, 1);
+                break;
+            } else if (0==k) {
+                return;
+            } else {
+                z[k].ind = 0;
+                a.adv(k, 1-z[k].len);
+            }
+        }
+    }
+}
+
+// Assignment ops, cf RA_ASSIGNOPS_LINE. These can run in parallel only if the destination moves along every axis, so that no two chunks write to the same place.
+
+constexpr bool
+moves(auto const & s)
+{
+    if constexpr (requires { []<class ... T>(std::tuple<T ...> const &){}(s); }) {
+        return std::apply([](auto const & ... s){ return (moves(s) && ...); }, s);
+    } else {
+        return 0!=s;
+    }
+}
+
+// Aliasing in assignment. A leaf of the source that shares memory with the destination y is harmless if it is y itself. If it has
+// the same steps as y but a different position, the assignment can still be done in place, by traversing y in increasing or decreasing
+// address order, as long as y doesn't overlap itself. Otherwise y is computed on a temporary. Only Cell leaves are considered.
+
+// f(cp, stepk) for each Cell leaf of a with rank 0 cells. m(k) is the axis of a that moves on axis k of the root, or -1, and stepk(k)
+// is the step of the leaf on axis k of the root.
+constexpr void
+for_cells(auto const & a, auto const & m, auto && f)
+{
+    using A = std::decay_t<decltype(a)>;
+    if constexpr (is_match<A>) {
+        std::apply([&](auto const & ... p){ (for_cells(p, m, f), ...); }, a.t);
+    } else if constexpr (is_reframe<A>) {
+        for_cells(a.a, [&m](rank_t k){ rank_t l = m(k); return l>=0 ? rank_t(A::orig(l)) : rank_t(-1); }, f);
+    } else if constexpr (is_cell<A>) {
+        if constexpr (0==A::cellr) {
+            f(a.c.cp, [&a, &m](rank_t k){ rank_t l = m(k); return l>=0 ? dim_t(a.step(l)) : dim_t(0); });
+        }
+    }
+}
+
+// Whether a has any Cell leaves that for_cells would visit, with pointer to T.
+template <class T, class A>
+constexpr bool has_cell_of = [] {
+    if constexpr (is_match<A>) {
+        return []<class ... P>(std::tuple<P ...> const *){ return (has_cell_of<T, std::decay_t<P>> || ...); }((decltype(A::t) *)nullptr);
+    } else if constexpr (is_reframe<A>) {
+        return has_cell_of<T, std::decay_t<decltype(A::a)>>;
+    } else if constexpr (is_cell<A>) {
+        using P = decltype(A::c.cp);
+        return 0==A::cellr && std::is_pointer_v<P> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<P>>, T>;
+    } else {
+        return false;
+    }
+}();
+
+// Offsets [lo, hi] of the elements of a leaf with steps stepk(k) and lens len(k).
+constexpr std::array<dim_t, 2>
+alias_extent(rank_t rank, auto const & stepk, auto const & len)
+{
+    dim_t lo = 0, hi = 0;
+    for (rank_t k=0; k<rank; ++k) {
+        dim_t d = stepk(k)*(len(k)-1);
+        (d<0 ? lo : hi) += d;
+    }
+    return { lo, hi };
+}
+
+// f(cp, stepk) for each Cell leaf of x whose address range overlaps that of y. Return whether there was any. y and x have ranks
+// yrank, xrank and lens ylen(k), xlen(k).
+inline bool
+alias_overlap(auto const & y, rank_t yrank, auto const & ylen, auto const & x, rank_t xrank, auto const & xlen, auto && f)
+{
+    using T = std::remove_cvref_t<decltype(*y.c.cp)>;
+    auto addr = [](auto p, dim_t d){ return std::intptr_t(p) + std::intptr_t(d*dim_t(sizeof(T))); };
+    auto [ylo, yhi] = alias_extent(yrank, [&y](rank_t k){ return dim_t(y.step(k)); }, ylen);
+    bool any = false;
+    for_cells(x, [](rank_t k){ return k; }, [&](auto cp, auto const & stepk){
+        if constexpr (std::is_pointer_v<decltype(cp)> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<decltype(cp)>>, T>) {
+            auto [lo, hi] = alias_extent(xrank, stepk, xlen);
+            if (!(addr(cp, hi)<addr(y.c.cp, ylo) || addr(y.c.cp, yhi)<addr(cp, lo))) {
+                any = true;
+                f(cp, stepk);
+            }
+        }
+    });
+    return any;
+}
+
+// 0: no aliasing, ±1: traverse in increasing/decreasing address order of y, 2: use a temporary.
+inline int
+alias_dir(auto const & y, auto const & x, rank_t rank, auto const & len)
+{
+    auto ystep = [&y](rank_t k){ return dim_t(y.step(k)); };
+    int dir = 0;
+    alias_overlap(y, rank, len, x, rank, len, [&](auto cp, auto const & stepk){
+        if (2==dir) {
+            return;
+        }
+        for (rank_t k=0; k<rank; ++k) {
+            if (stepk(k)!=ystep(k)) {
+                dir = 2;
+                return;
+            }
+        }
+        if (std::intptr_t d = std::intptr_t(cp)-std::intptr_t(y.c.cp); 0!=d) {
+            int s = d>0 ? 1 : -1;
+            dir = (0==dir || s==dir) ? s : 2;
+        }
+    });
+    if (1==dir || -1==dir) {
+// y must not overlap itself. Check that each step is larger than the extent of the smaller steps.
+        ply_axes z(rank);
+        ply_sort([&](rank_t k){ return step_cost(ystep(k)); }, [&z](int i) -> rank_t & { return z[i].order; }, rank);
+        dim_t ext = 0;
+        for (rank_t i=0; i<rank; ++i) {
+            rank_t k = z[i].order;
+            if (1!=len(k)) {
+                dim_t s = std::abs(ystep(k));
+                if (s<=ext) {
+                    return 2;
+                }
+                ext += s*(len(k)-1);
+            }
+        }
+    }
+    return dir;
+}
+
+// Size of the temporary for a destination of type Y, if it can be known at compile time.
+template <class Y>
+constexpr dim_t alias_span_s = [] {
+    if constexpr (ANY!=rank_s<Y>() && requires { Y::len(0); Y::step(0); }) {
+        auto [lo, hi] = alias_extent(rank_s<Y>(), [](rank_t k){ return dim_t(Y::step(k)); }, [](rank_t k){ return dim_t(Y::len(k)); });
+        return hi-lo+1;
+    } else {
+        return ANY;
+    }
+}();
+
+// Traverse a with the axes z, inner first, each axis backwards if back(k) for k the axis of a.
+inline void
+ply_directed(Iterator auto & a, ply_axis * z, rank_t rank, auto const & back)
+{
+    for (rank_t i=0; i<rank; ++i) {
+        z[i].ind = 0;
+        if (back(z[i].order)) {
+            a.adv(z[i].order, z[i].len-1);
+        }
+    }
+    dim_t d0 = back(z[0].order) ? -1 : 1;
+    for (;;) {
+        for (dim_t s=z[0].len; --s>=0; a.adv(z[0].order, d0)) {
+            *a;
+        }
+        a.adv(z[0].order, -d0*z[0].len);
+        for (rank_t k=1; ; ++k) {
+            if (k>=rank) {
+                return;
+            }
+            dim_t dk = back(z[k].order) ? -1 : 1;
+            if (++z[k].ind<z[k].len) {
+                a.adv(z[k].order, dk);
+                break;
+            } else {
+                z[k].ind = 0;
+                a.adv(z[k].order, dk*(1-z[k].len));
+            }
+        }
+    }
+}
+
+// Whether y shares memory with the Cell leaves of x other than element by element, for lens len(k) of both.
+inline bool
+alias_cells(auto const & y, auto const & x, rank_t rank, auto const & len)
+{
+    using Y = std::decay_t<decltype(y)>;
+    if constexpr (!is_cell<Y>) {
+        return false;
+    } else if constexpr (0!=Y::cellr || !std::is_pointer_v<decltype(Y::c.cp)>) {
+        return false;
+    } else if constexpr (!has_cell_of<std::remove_cvref_t<decltype(*Y::c.cp)>, std::decay_t<decltype(x)>>) {
+        return false;
+    } else {
+        for (rank_t k=0; k<rank; ++k) {
+            if (0>=len(k)) {
+                return false;
+            }
+        }
+        return 0<rank && 0!=alias_dir(y, x, rank, len);
+    }
+}
+
+// Whether y may share memory with the Cell leaves of x, when y and x have their own shapes. y must be a Cell.
+inline bool
+alias_any(auto const & y, auto const & x)
+{
+    using Y = std::decay_t<decltype(y)>;
+    if constexpr (0!=Y::cellr || !std::is_pointer_v<decltype(Y::c.cp)>) {
+        return true;
+    } else if constexpr (!has_cell_of<std::remove_cvref_t<decltype(*Y::c.cp)>, std::decay_t<decltype(x)>>) {
+        return false;
+    } else {
+        return alias_overlap(y, ra::rank(y), [&y](rank_t k){ return dim_t(y.len(k)); },
+                             x, ra::rank(x), [&x](rank_t k){ return dim_t(x.len(k)); }, [](auto, auto const &){});
+    }
+}
+
+// Assignment e = map(op, y, x) where y may share memory with x. Return false if nothing was done. The check is skipped at compile
+// time unless x has Cell leaves of the same type as y, so it costs nothing for sources such as scalars, iotas, or arrays of another
+// type. Otherwise the address ranges are compared first, and only overlapping leaves are looked at further.
+inline bool
+ply_alias(auto & e)
+{
+    using Y = std::decay_t<decltype(get<0>(e.t))>;
+    if constexpr (!is_cell<Y>) {
+        return false;
+    } else if constexpr (0!=Y::cellr || !std::is_pointer_v<decltype(Y::c.cp)>) {
+        return false;
+    } else if constexpr (!has_cell_of<std::remove_cvref_t<decltype(*Y::c.cp)>, std::decay_t<decltype(get<1>(e.t))>>) {
+        return false;
+    } else {
+        auto & y = get<0>(e.t);
+        using T = std::remove_cvref_t<decltype(*y.c.cp)>;
+        rank_t rank = ra::rank(e);
+        if (0==rank) {
+            return false;
+        }
+        for (rank_t k=0; k<rank; ++k) {
+            if (0>=e.len(k)) {
+                return false;
+            }
+        }
+        auto len = [&e](rank_t k){ return dim_t(e.len(k)); };
+        if (!alias_overlap(y, rank, len, get<1>(e.t), rank, len, [](auto, auto const &){})) {
+            return false;
+        }
+        int dir = alias_dir(y, get<1>(e.t), rank, len);
+        if (0==dir) {
+            return false;
+        }
+        validate(e);
+        if (2!=dir) {
+            ply_axes z(rank);
+            ply_sort([&](rank_t k){ return step_cost(y.step(k)); }, [&z](int i) -> rank_t & { return z[i].order; }, rank);
+            for (rank_t i=0; i<rank; ++i) { z[i].len = len(z[i].order); }
+            ply_directed(e, z.data(), rank, [&y, dir](rank_t k){ return dir*y.step(k)<0; });
+            return true;
+        } else if constexpr (std::is_default_constructible_v<T> && std::is_copy_assignable_v<T>) {
+            auto [lo, hi] = alias_extent(rank, [&y](rank_t k){ return dim_t(y.step(k)); }, len);
+            auto run = [&](T * buf){
+                auto y0 = y, t = y;
+                t.c.cp = buf-lo;
+                ply(map([](auto & t, auto const & y){ t = y; }, auto(t), auto(y0)));
+                y.c.cp = t.c.cp;
+                ply(e);
+                ply(map([](auto & y, auto const & t){ y = t; }, auto(y0), auto(t)));
+            };
+// fixed size destinations use the stack.
+            if constexpr (constexpr dim_t span = alias_span_s<Y>; ANY!=span && span*dim_t(sizeof(T))<=(1<<12)) {
+                std::array<T, span> buf;
+                run(buf.data());
+            } else {
+                std::vector<T> buf(hi-lo+1);
+                run(buf.data());
+            }
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+// Gather and scatter. a(i) or a(i, j) with integer index arrays i, j of rank 1, on a view a of rank 1 or 2, is a Map of gather_t on
+// i or on (i, j) as an outer product. The result is an lvalue, so a(i) = x scatters. Duplicate indices in a scatter are written in
+// traversal order, so with = only one of the values is kept, and with op= all of them are applied. Scatters never run in parallel.
+
+template <class P, int N>
+struct gather_t
+{
+    P cp;
+    std::array<dim_t, N> step, len;
+    constexpr decltype(auto)
+    operator()(auto const & ... i) const
+    {
+        static_assert(N==sizeof...(i));
+        return [&]<int ... k>(ilist_t<k ...>) -> decltype(auto) {
+            RA_CK(((0<=i && i<len[k]) && ...), "Out of range index ", std::array { dim_t(i) ... }, " for lens ", len, ".");
+            return cp[(0 + ... + i*step[k])];
+        }(mp::iota<N> {});
+    }
+};
+
+template <class A> concept is_gather = requires (A a) { []<class P, int N, class T, class K>(Map<gather_t<P, N>, T, K> const &){}(a); };
+
+template <class A> concept is_ptr_cell1 = is_cell<A> && 1==rank_s<A>() && 0==std::decay_t<A>::cellr && std::is_pointer_v<decltype(std::declval<A>().c.cp)>;
+
+constexpr void
+prefetch([[maybe_unused]] auto const * p)
+{
+#if defined(__GNUC__)
+    if !consteval {
+        __builtin_prefetch(p);
+    }
+#endif
+}
+
+// Whether p[0 ... (n-1)*s] and q[0 ... (m-1)*t] may share memory, cf alias_overlap. Leaves of different types are assumed not to.
+constexpr bool
+alias_line(auto p, dim_t s, dim_t n, auto q, dim_t t, dim_t m)
+{
+    using P = decltype(p);
+    using Q = decltype(q);
+    if constexpr (std::is_pointer_v<P> && std::is_pointer_v<Q>
+                  && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<P>>, std::remove_cv_t<std::remove_pointer_t<Q>>>) {
+        if (0>=n || 0>=m) {
+            return false;
+        }
+        auto addr = [](auto p, dim_t d){ return std::intptr_t(p) + std::intptr_t(d*dim_t(sizeof(*p))); };
+        auto [plo, phi] = alias_extent(1, [s](rank_t){ return s; }, [n](rank_t){ return n; });
+        auto [qlo, qhi] = alias_extent(1, [t](rank_t){ return t; }, [m](rank_t){ return m; });
+        return !(addr(q, qhi)<addr(p, plo) || addr(p, phi)<addr(q, qlo));
+    } else {
+        return false;
+    }
+}
+
+// 1-D gather to a Cell or scatter from a Cell with an index array in memory. Software prefetch of the random side, RA_PREFETCH
+// elements ahead, when it doesn't fit in cache. Hardware gathers are left to the compiler. If the destination overlaps the gathered
+// array or the indices, as in a = a(i), or the source overlaps the scattered array, as in a(i) = a, the operands that may be
+// overwritten are read into temporaries first.
+constexpr bool
+ply_gather(auto && op, auto & y, auto const & x)
+{
+    using Y = std::decay_t<decltype(y)>;
+    using X = std::decay_t<decltype(x)>;
+    auto run = [](auto const & g, auto ip, dim_t is, dim_t n, auto && f){
+        dim_t k = 0;
+// only for data in memory. The index ahead hasn't been checked yet, so skip it if it's out of range.
+        if constexpr (std::is_pointer_v<decltype(g.cp)>) {
+            constexpr dim_t d = RA_PREFETCH;
+            if (0<d && g.len[0]*dim_t(sizeof(*g.cp))>(1<<15)) {
+                for (; k+d<n; ++k) {
+                    if (dim_t j=ip[(k+d)*is]; 0<=j && j<g.len[0]) {
+                        prefetch(g.cp + j*g.step[0]);
+                    }
+                    f(k, g(ip[k*is]));
+                }
+            }
+        }
+        for (; k<n; ++k) {
+            f(k, g(ip[k*is]));
+        }
+    };
+    if constexpr (is_gather<X> && is_ptr_cell1<Y>) {
+        if constexpr (1==rank_s<X>() && is_ptr_cell1<decltype(get<0>(x.t))>) {
+            auto const & ix = get<0>(x.t);
+            dim_t n = ix.len(0);
+            RA_CK(y.len(0)==n, "Mismatched lengths ", y.len(0), " ", n, ".");
+            auto yp = y.c.cp;
+            dim_t ys = y.step(0);
+            if (alias_line(yp, ys, n, x.op.cp, x.op.step[0], x.op.len[0]) || alias_line(yp, ys, n, ix.c.cp, ix.step(0), n)) {
+                using T = std::decay_t<decltype(x.op(dim_t(0)))>;
+                if constexpr (std::is_default_constructible_v<T> && std::is_copy_assignable_v<T>) {
+                    std::vector<T> t(n);
+                    run(x.op, ix.c.cp, ix.step(0), n, [&t](dim_t k, auto && a){ t[k] = RA_FW(a); });
+                    for (dim_t k=0; k<n; ++k) { op(yp[k*ys], t[k]); }
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+            run(x.op, ix.c.cp, ix.step(0), n, [&op, yp, ys](dim_t k, auto && a){ op(yp[k*ys], RA_FW(a)); });
+            return true;
+        }
+    } else if constexpr (is_gather<Y> && is_ptr_cell1<decltype(iter(x))>) {
+        if constexpr (1==rank_s<Y>() && is_ptr_cell1<decltype(get<0>(y.t))>) {
+            auto const & ix = get<0>(y.t);
+            auto xi = iter(x);
+            dim_t n = ix.len(0);
+            RA_CK(xi.len(0)==n, "Mismatched lengths ", n, " ", xi.len(0), ".");
+            auto const & g = y.op;
+            auto scatter = [&](auto ip, dim_t is, auto xp, dim_t xs){
+                run(g, ip, is, n, [&op, xp, xs](dim_t k, auto && b){ op(RA_FW(b), xp[k*xs]); });
+            };
+            bool ax = alias_line(g.cp, g.step[0], g.len[0], xi.c.cp, xi.step(0), n);
+            bool ai = alias_line(g.cp, g.step[0], g.len[0], ix.c.cp, ix.step(0), n);
+            if (ax || ai) {
+                using T = std::decay_t<decltype(*xi.c.cp)>;
+                using I = std::decay_t<decltype(*ix.c.cp)>;
+                if constexpr (std::is_default_constructible_v<T> && std::is_copy_assignable_v<T>) {
+                    std::vector<T> t(ax ? n : 0);
+                    std::vector<I> i(ai ? n : 0);
+                    for (dim_t k=0; k<dim_t(t.size()); ++k) { t[k] = xi.c.cp[k*xi.step(0)]; }
+                    for (dim_t k=0; k<dim_t(i.size()); ++k) { i[k] = ix.c.cp[k*ix.step(0)]; }
+                    scatter(ai ? i.data() : ix.c.cp, ai ? 1 : ix.step(0), ax ? t.data() : xi.c.cp, ax ? 1 : xi.step(0));
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+            scatter(ix.c.cp, ix.step(0), xi.c.cp, xi.step(0));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Frame of a without axis ax. operator* gives a itself, at the start of a line along ax.
 
-template <class Early = none_t>
-constexpr auto
-ply_ravel(Iterator auto && a, Early const & early = none)
+template <int ax, Iterator A>
+struct Drop
 {
-    validate(a);
-    rank_t rank = ra::rank(a);
-    if (0==rank) {
-        if constexpr (requires { none_t(early); }) {
-            *a; return;
-        } else {
-            return (*a).value_or(early);
+    static_assert(ax>=0 && (ANY==rank_s<A>() || ax<rank_s<A>()), "Bad axis.");
+    mutable A a; // cf Reduce::operator*
+
+    constexpr static int fwd(int k) { return k<ax ? k : k+1; }
+    consteval static rank_t rank() requires (ANY!=rank_s<A>()) { return rank_s<A>()-1; }
+    constexpr rank_t rank() const requires (ANY==rank_s<A>()) { return ra::rank(a)-1; }
+    constexpr static dim_t len_s(int k) { return std::decay_t<A>::len_s(fwd(k)); }
+    constexpr static dim_t len(int k) requires (requires { std::decay_t<A>::len(k); }) { return std::decay_t<A>::len(fwd(k)); }
+    constexpr dim_t len(int k) const requires (!(requires { std::decay_t<A>::len(k); })) { return a.len(fwd(k)); }
+    constexpr static bool keep(dim_t st, int z, int j) requires (requires { std::decay_t<A>::keep(st, z, j); }) { return std::decay_t<A>::keep(st, fwd(z), fwd(j)); }
+    constexpr bool keep(dim_t st, int z, int j) const requires (!(requires { std::decay_t<A>::keep(st, z, j); })) { return a.keep(st, fwd(z), fwd(j)); }
+    constexpr static auto step(int k) requires (requires { std::decay_t<A>::step(k); }) { return std::decay_t<A>::step(fwd(k)); }
+    constexpr auto step(int k) const requires (!(requires { std::decay_t<A>::step(k); })) { return a.step(fwd(k)); }
+    constexpr void adv(rank_t k, dim_t d) { a.adv(fwd(k), d); }
+    constexpr auto save() const { return a.save(); }
+    constexpr void load(auto const & p) { a.load(p); }
+    constexpr void mov(auto const & s) { a.mov(s); }
+    constexpr A const & operator*() const { return a; }
+};
+
+// Lazy reduction along axis ax of a, folding op from z. If z is none, the fold starts from the first element on ax. operator* runs the
+// fold with ax inner. When Reduce is the whole source of an assignment and ax isn't the innermost axis of a in memory, into() is used
+// instead. It accumulates on the destination with a single ply() of a, so the order is picked by the layout of a as for any other
+// expression, and the inner loop runs over kept axes. The destination is the target of the assignment if that is plain = and it
+// doesn't overlap a, else a temporary.
+
+template <int ax, class Op, class Z, Iterator A>
+struct Reduce: public Drop<ax, A>
+{
+    using Drop<ax, A>::a, Drop<ax, A>::fwd;
+    Op op;
+    Z z;
+
+    constexpr auto
+    operator*() const
+    {
+        auto p = a.save();
+        auto s = a.step(ax);
+        dim_t n = a.len(ax);
+        auto c = [&]{
+            if constexpr (std::is_same_v<Z, none_t>) {
+                RA_CK(n>0, "Empty reduction without initial value.");
+                std::decay_t<decltype(*a)> c = *a;
+                a.mov(s); --n;
+                return c;
+            } else {
+                return std::decay_t<decltype(std::invoke(op, z, *a))>(z);
+            }
+        }();
+        for (; n>0; --n, a.mov(s)) { c = std::invoke(op, std::move(c), *a); }
+        a.load(p);
+        return c;
+    }
+// ax is innermost in memory among the axes of a that move, as far as can be told.
+    constexpr bool
+    inner() const
+    {
+        auto lead = [](this auto const & lead, auto const & b, rank_t k) -> dim_t {
+            using B = std::decay_t<decltype(b)>;
+            if constexpr (is_match<B>) {
+                return std::apply([&](auto const & ... c){ dim_t s=0; ((s = (0==s ? lead(c, k) : s)), ...); return s; }, b.t);
+            } else if constexpr (is_cell<B>) {
+                return k<ra::rank(b) ? std::abs(dim_t(b.step(k))) : 0;
+            } else {
+                return 0;
+            }
+        };
+        dim_t sa = lead(a, ax);
+        for (rank_t k=0; sa>0 && k<ra::rank(a); ++k) {
+            if (dim_t sk=lead(a, k); k!=ax && a.len(k)>1 && 0<sk && sk<sa) {
+                return false;
+            }
         }
+        return true;
     }
-// inside first. FIXME better heuristic - but first need a way to force row-major
-    struct z_t { rank_t order; dim_t sha, ind=0; };
-    thread_local std::vector<z_t> z(4);
-    z.resize(rank);
-    for (rank_t i=0; i<rank; ++i) {
-        z[i].order = rank-1-i;
+// y has the shape of the result.
+    constexpr void
+    into(auto && y) const requires (!std::is_same_v<Z, none_t> && ANY!=rank_s<A>())
+    {
+        ply(map([this](auto & y){ y = z; }, y));
+        [&]<int ... k>(ilist_t<k ...>){
+            ply(map([this](auto & y, auto && a){ y = std::invoke(op, std::move(y), RA_FW(a)); }, reframe(auto(y), ilist<fwd(k) ...>), a));
+        }(mp::iota<rank_s<A>()-1> {});
     }
-// find outermost compact dim.
-    auto ocd = z.begin();
-    dim_t ss = a.len(ocd->order);
-    for (--rank, ++ocd; rank>0 && a.keep(ss, z[0].order, ocd->order); --rank, ++ocd) {
-        ss *= a.len(ocd->order);
+};
+
+template <class A> concept is_reduce = requires (A a) { []<int ax, class Op, class Z, class B>(Reduce<ax, Op, Z, B> const &){}(a); };
+
+template <int ax>
+constexpr auto
+reduce_axis(auto && op, auto && z, auto && a)
+{
+    using A = std::decay_t<decltype(iter(RA_FW(a)))>;
+    return Reduce<ax, std::decay_t<decltype(op)>, std::decay_t<decltype(z)>, A> { { iter(RA_FW(a)) }, RA_FW(op), RA_FW(z) };
+}
+
+// The identities of std::plus<> and std::multiplies<> are known.
+template <int ax>
+constexpr auto
+reduce_axis(auto && op, auto && a)
+{
+    using Op = std::decay_t<decltype(op)>;
+    using T = ncvalue_t<decltype(a)>;
+    if constexpr (std::is_same_v<Op, std::plus<>>) {
+        return reduce_axis<ax>(RA_FW(op), T(0), RA_FW(a));
+    } else if constexpr (std::is_same_v<Op, std::multiplies<>>) {
+        return reduce_axis<ax>(RA_FW(op), T(1), RA_FW(a));
+    } else {
+        return reduce_axis<ax>(RA_FW(op), none, RA_FW(a));
     }
-    for (int k=0; k<rank; ++k) {
-// ss takes care of the raveled dimensions ss.
-        if (0>=(z[k].sha=a.len(ocd[k].order))) {
-            if constexpr (requires { none_t(early); }) {
-                return;
+}
+
+// Inclusive or exclusive (ex) scan along axis ax of a, folding op from z. If z is none, the inclusive scan starts from the first element on
+// ax. Scan can only be the source of an assignment, see ply_assign().
+
+template <int ax, class Op, class Z, Iterator A, bool ex>
+struct Scan
+{
+    static_assert(!(ex && std::is_same_v<Z, none_t>), "Exclusive scan needs an initial value.");
+    using V = std::decay_t<decltype(*std::declval<A const &>())>;
+    using C = std::decay_t<decltype(std::invoke(std::declval<Op const &>(), std::declval<std::conditional_t<std::is_same_v<Z, none_t>, V, Z>>(), std::declval<V>()))>;
+    Op op;
+    Z z;
+    A a;
+
+// Run g(y, c) on n elements of y along ax, where c is the scan of b continuing from c. Return the last c.
+    constexpr C
+    line(auto && g, auto y, auto b, dim_t n, C c) const
+    {
+        auto sy = y.step(ax);
+        auto sb = b.step(ax);
+        for (; n>0; --n, y.mov(sy), b.mov(sb)) {
+            if constexpr (ex) {
+                V v = *b; // y may be b
+                g(*y, std::as_const(c));
+                c = std::invoke(op, std::move(c), std::move(v));
             } else {
-                return early;
+                c = std::invoke(op, std::move(c), *b);
+                g(*y, std::as_const(c));
             }
         }
+        return c;
     }
-    auto ss0 = a.step(z[0].order);
-    for (;;) {
-        auto place = a.save();
-        for (dim_t s=ss; --s>=0; a.mov(ss0)) {
-            if constexpr (requires { none_t(early); }) {
-                *a;
-            } else {
-                if (auto stop = *a) {
-                    return stop.value();
+// Same, from the start of the line.
+    constexpr void
+    run(auto && g, auto y, auto b, dim_t n) const
+    {
+        if constexpr (std::is_same_v<Z, none_t>) {
+            if (n>0) {
+                C c(*b);
+                g(*y, std::as_const(c));
+                y.adv(ax, 1);
+                b.adv(ax, 1);
+                line(g, y, b, n-1, std::move(c));
+            }
+        } else {
+            line(g, y, b, n, C(z));
+        }
+    }
+// Fold n>0 elements of b along ax, starting from the first.
+    constexpr C
+    fold(auto b, dim_t n) const
+    {
+        C c(*b);
+        b.adv(ax, 1);
+        for (auto sb=b.step(ax); --n>0; b.mov(sb)) { c = std::invoke(op, std::move(c), *b); }
+        return c;
+    }
+};
+
+template <class A> concept is_scan = requires (A a) { []<int ax, class Op, class Z, class B, bool ex>(Scan<ax, Op, Z, B, ex> const &){}(a); };
+
+template <int ax=0, bool ex=false>
+constexpr auto
+scan(auto && op, auto && z, auto && a)
+{
+    using A = std::decay_t<decltype(iter(RA_FW(a)))>;
+    return Scan<ax, std::decay_t<decltype(op)>, std::decay_t<decltype(z)>, A, ex> { RA_FW(op), RA_FW(z), iter(RA_FW(a)) };
+}
+
+template <int ax=0, bool ex=false>
+constexpr auto
+scan(auto && op, auto && a)
+{
+    using Op = std::decay_t<decltype(op)>;
+    using T = ncvalue_t<decltype(a)>;
+    if constexpr (std::is_same_v<Op, std::plus<>>) {
+        return scan<ax, ex>(RA_FW(op), T(0), RA_FW(a));
+    } else if constexpr (std::is_same_v<Op, std::multiplies<>>) {
+        return scan<ax, ex>(RA_FW(op), T(1), RA_FW(a));
+    } else {
+        return scan<ax, ex>(RA_FW(op), none, RA_FW(a));
+    }
+}
+
+template <int ax=0> constexpr auto exscan(auto && op, auto && z, auto && a) { return scan<ax, true>(RA_FW(op), RA_FW(z), RA_FW(a)); }
+template <int ax=0> constexpr auto exscan(auto && op, auto && a) { return scan<ax, true>(RA_FW(op), RA_FW(a)); }
+
+constexpr void
+ply_assign(auto && op, auto && y, auto && x)
+{
+    using X = std::decay_t<decltype(x)>;
+    if constexpr (is_reduce<X> && requires { x.into(x.a); }) {
+        if !consteval {
+            constexpr rank_t R = X::rank();
+            std::array<dim_t, R> lens;
+            dim_t n = 1;
+            for (rank_t k=0; k<R; ++k) { lens[k] = x.len(k); n *= std::max(lens[k], dim_t(0)); }
+            if (!x.inner() && std::ranges::all_of(lens, [](dim_t l){ return l>=0; })) {
+                using Y = std::decay_t<decltype(y)>;
+                if constexpr (requires { std::decay_t<decltype(op)>::set; } && is_cell<Y>) {
+                    if constexpr (std::decay_t<decltype(op)>::set && R==rank_s<Y>()) {
+                        bool same = true;
+                        for (rank_t k=0; k<R; ++k) { same = same && lens[k]==y.len(k); }
+                        if (same && !alias_any(y, x.a)) {
+                            x.into(auto(y));
+                            return;
+                        }
+                    }
                 }
+                using T = std::decay_t<decltype(*x)>;
+                std::vector<T> buf(n);
+                auto t = ViewBig<T *, R>(lens, buf.data());
+                x.into(iter(t));
+                ply_assign(RA_FW(op), RA_FW(y), iter(t));
+                return;
             }
         }
-        a.load(place); // FIXME wasted if k=0. Cf test/iota.cc
-        for (int k=0; ; ++k) {
-            if (k>=rank) {
-                if constexpr (requires { none_t(early); }) {
+    }
+    if !consteval {
+        if (ply_gather(op, y, x)) {
+            return;
+        }
+    }
+    auto e = map(RA_FW(op), RA_FW(y), RA_FW(x));
+    if !consteval {
+        if (ply_alias(e)) {
+            return;
+        }
+    }
+    if constexpr (ANY==size_s<decltype(e)>() && !is_gather<std::decay_t<decltype(y)>>) {
+        if !consteval {
+            if (1!=assign_par.nthreads) {
+                bool ok = true;
+                for (rank_t k=0; ok && k<ra::rank(e); ++k) {
+                    ok = moves(get<0>(e.t).step(k));
+                }
+                if (ok) {
+                    ply(assign_par, std::move(e));
                     return;
-                } else {
-                    return early;
                 }
-            } else if (++z[k].ind<z[k].sha) {
-                a.adv(ocd[k].order, 1);
-                break;
-            } else {
-                z[k].ind = 0;
-                a.adv(ocd[k].order, 1-z[k].sha);
             }
         }
     }
+    ply(std::move(e));
 }
 
-// compile time order/rank.
-
-template <auto order, int k, int urank, class S, class Early>
-constexpr auto
-subply(Iterator auto & a, dim_t s, S const & ss0, Early const & early)
+// y op= scan without temporaries. A 1-D scan under assign_par runs in three phases: fold each block, scan the block totals, and scan
+// each block from its offset. Otherwise the lines along ax are independent and they are split as in ply_assign.
+template <int ax, class Op, class Z, class A, bool ex>
+constexpr void
+ply_scan(auto && op, auto && y, Scan<ax, Op, Z, A, ex> const & x)
 {
-    if constexpr (k < urank) {
-        auto place = a.save();
-        for (; --s>=0; a.mov(ss0)) {
-            if constexpr (requires { none_t(early); }) {
-                *a;
-            } else {
-                if (auto stop = *a) {
-                    return stop;
-                }
-            }
+    using C = Scan<ax, Op, Z, A, ex>::C;
+    dim_t n = x.a.len(ax);
+    RA_CK(ra::rank(y)==ra::rank(x.a) && y.len(ax)==n, "Mismatched shapes ", std::format("{:l}", ra::shape(y)), " ", std::format("{:l}", ra::shape(x.a)), ".");
+// in place is fine, but not if y is shifted or permuted from x.
+    if !consteval {
+        if (alias_cells(y, x.a, ra::rank(y), [&x](rank_t k){ return dim_t(x.a.len(k)); })) {
+            using V = Scan<ax, Op, Z, A, ex>::V;
+            std::vector<V> buf(ra::size(x.a));
+            auto t = ViewBig<V *, rank_s<A>()>(ra::shape(x.a), buf.data());
+            ply(map([](auto & t, auto && a){ t = RA_FW(a); }, iter(t), auto(x.a)));
+            ply_scan(RA_FW(op), RA_FW(y), scan<ax, ex>(x.op, x.z, t));
+            return;
         }
-        a.load(place); // FIXME wasted if k was 0 at the top
+    }
+    if (1==ra::rank(x.a)) {
+        int nt = 1;
+        if !consteval {
+            nt = par_nthreads(assign_par, n, n);
+        }
+        if (1==nt) {
+            x.run(op, y, x.a, n);
+            return;
+        }
+        std::vector<C> part(nt, C(*x.a));
+        par_run(nt-1, [&](int t){
+            auto b = x.a;
+            b.adv(ax, par_begin(n, t, nt));
+            part[t] = x.fold(b, par_begin(n, t+1, nt)-par_begin(n, t, nt));
+        }, assign_par.pin);
+        C c = [&]{ if constexpr (std::is_same_v<Z, none_t>) return part[0]; else return C(std::invoke(x.op, C(x.z), part[0])); }();
+        for (int t=1; t<nt; ++t) {
+            C next = std::move(part[t]);
+            part[t] = c;
+            if (t+1<nt) { c = std::invoke(x.op, std::move(c), std::move(next)); }
+        }
+        par_run(nt, [&](int t){
+            dim_t lo = par_begin(n, t, nt), hi = par_begin(n, t+1, nt);
+            auto yt = y;
+            auto b = x.a;
+            yt.adv(ax, lo);
+            b.adv(ax, lo);
+            if (0==t) { x.run(op, yt, b, hi-lo); } else { x.line(op, yt, b, hi-lo, part[t]); }
+        }, assign_par.pin);
     } else {
-        dim_t size = a.len(order[k]); // TODO precompute above
-        for (dim_t i=0; i<size; ++i) {
-            if constexpr (requires { none_t(early); }) {
-                subply<order, k-1, urank>(a, s, ss0, early);
-            } else {
-                if (auto stop = subply<order, k-1, urank>(a, s, ss0, early)) {
-                    return stop;
+        auto e = map([&op, &x](auto const & y, auto const & b){ x.run(op, y, b, b.len(ax)); },
+                     Drop<ax, std::decay_t<decltype(y)>> { y }, Drop<ax, A> { x.a });
+        if !consteval {
+            if (1!=assign_par.nthreads) {
+                bool ok = true;
+                for (rank_t k=0; ok && k<ra::rank(e); ++k) {
+                    ok = moves(get<0>(e.t).step(k));
+                }
+                if (ok) {
+                    ply(assign_par, std::move(e));
+                    return;
                 }
             }
-            a.adv(order[k], 1);
         }
-        a.adv(order[k], -size);
+        ply(std::move(e));
     }
-    if constexpr (requires { none_t(early); }) {
-        return;
-    } else {
-        return static_cast<decltype(*a)>(std::nullopt);
+}
+
+constexpr void
+ply_assign(auto && op, auto && y, auto && x) requires (is_scan<std::decay_t<decltype(x)>>)
+{
+    ply_scan(RA_FW(op), RA_FW(y), x);
+}
+
+
+// Reductions. Each chunk t of the outermost loop accumulates on N lanes of its own. The inner loop runs in groups of N elements, and
+// element j of each group goes to lane j, so the lanes are independent accumulators that the compiler can keep in vector registers.
+// Every block elements, and at the end of the chunk, the lanes are combined in a fixed tree and folded into the accumulator of the
+// chunk. The chunks are combined in a fixed tree too, so the result only depends on the shape of the expression and on the number of
+// threads.
+
+template <class L, class K>
+struct reduce_op
+{
+    L * l;
+    K k;
+    constexpr void operator()(auto && ... a) const { k(*l, RA_FW(a) ...); }
+};
+
+constexpr int reduce_lanes = 8;
+
+constexpr void
+reduce_tree(auto & part, auto && combine)
+{
+    for (int w=1; w<int(part.size()); w*=2) {
+        for (int i=0; i+w<int(part.size()); i+=2*w) {
+            combine(part[i], part[i+w]);
+        }
     }
 }
 
-template <class Early = none_t>
-constexpr auto
-ply_fixed(Iterator auto && a, Early const & early = none)
+// Line of len elements of a, from its current position. left counts down the elements until the next flush.
+template <int N>
+constexpr void
+reduce_line(Iterator auto & a, dim_t len, auto const & ss0, auto & lane, dim_t & left, dim_t block, auto && flush)
 {
-    validate(a);
-    constexpr rank_t rank = rank_s(a);
-    static_assert(0<=rank, "ply_fixed requires static rank");
-    if constexpr (0==rank) {
-        if constexpr (requires { none_t(early); }) {
-            *a; return;
-        } else {
-            return (*a).value_or(early);
+    auto at = [&a](auto & l){ std::apply([&](auto const & ... p){ a.op.k(l, *p ...); }, a.t); };
+    auto place = a.save();
+    while (len>0) {
+        dim_t m = std::min(len, left);
+        for (dim_t g=m/N; --g>=0; ) {
+            [&]<int ... j>(ilist_t<j ...>){ ((at(lane[j]), a.mov(ss0)), ...); }(mp::iota<N> {});
         }
+        for (int j=0; j<int(m%N); ++j, a.mov(ss0)) {
+            at(lane[j]);
+        }
+        len -= m;
+        if (0==(left -= m)) {
+            flush();
+            left = block;
+        }
+    }
+    a.load(place);
+}
+
+// c is the accumulator and l the start value of the lanes. The lanes take k(lane, a ...) and are combined with lc(lane, lane), and
+// fold(c, lane) folds them into c. Chunks start from a copy of c and are combined with combine(c, c). For a plain reduction all these
+// are the same op, and c must be its identity.
+template <int N=reduce_lanes>
+constexpr void
+reduce_blocks(par_t const & p, auto & c, auto const & l, auto && k, auto && lc, auto && fold, auto && combine, dim_t block,
+              auto && ... x)
+{
+    using C = std::remove_reference_t<decltype(c)>;
+    using L = std::decay_t<decltype(l)>;
+    using K = std::decay_t<decltype(k)>;
+    L l0 = l;
+    auto a = map(reduce_op<L, K> { &l0, RA_FW(k) }, RA_FW(x) ...);
+// short expressions of static size aren't worth the lanes.
+    auto serial = [&]{ ply(std::move(a)); fold(c, l0); };
+    if consteval {
+        serial();
+    } else if constexpr (ANY!=size_s(a) && size_s(a)<2*N) {
+        serial();
     } else {
-// inside first. FIXME better heuristic - but first need a way to force row-major
-        constexpr auto order = []<class ... I>(list<I ...>){ return std::array<int, rank>{(rank-1-I{}) ...}; }(mp::iota<rank>{});
-#pragma GCC diagnostic push
-#pragma GCC diagnostic warning "-Warray-bounds"
-        auto ss0 = a.step(order[0]); // gcc 14.1 with RA_CHECK=0 and sanitizer on
-#pragma GCC diagnostic pop
-        if constexpr (requires { none_t(early); }) {
-            subply<order, rank-1, 1>(a, a.len(order[0]), ss0, early);
+        validate(a);
+        RA_PROBE("ply_reduce", ra::size(a));
+        rank_t rank = ra::rank(a);
+        if (0==rank) {
+            *a; fold(c, l0); return;
+        }
+        ply_axes z(rank);
+        rank_t n = ply_plan(a, z.data(), rank);
+        RA_PROBE_PLAN(z[0].len, 0==n);
+        dim_t size = 1;
+        for (int k=0; k<=n; ++k) {
+            if (0>=z[k].len) {
+                return;
+            }
+            size *= z[k].len;
+        }
+        int nt = par_nthreads(p, size, z[n].len);
+        std::vector<C> part(nt, c);
+        auto run = [&](auto const & ss0){
+            par_run(nt, [&](int t){
+                std::array<L, N> lane;
+                lane.fill(l);
+                auto flush = [&]{ reduce_tree(lane, lc); fold(part[t], lane[0]); lane.fill(l); };
+                dim_t left = block;
+                ply_axes zt(n+1);
+                std::copy(z.data(), z.data()+n+1, zt.data());
+                dim_t i0 = par_begin(z[n].len, t, nt), i1 = par_begin(z[n].len, t+1, nt);
+                auto ta = a;
+                ta.adv(zt[n].order, i0);
+                zt[n].len = i1-i0;
+                for (;;) {
+                    reduce_line<N>(ta, zt[0].len, ss0, lane, left, block, flush);
+                    int k = 1;
+                    for (; k<=n; ++k) {
+                        if (++zt[k].ind<zt[k].len) {
+                            ta.adv(zt[k].order, 1);
+                            break;
+                        } else {
+                            zt[k].ind = 0;
+                            ta.adv(zt[k].order, 1-zt[k].len);
+                        }
+                    }
+                    if (k>n) {
+                        break;
+                    }
+                }
+                if (left<block) {
+                    flush();
+                }
+            }, p.pin);
+        };
+        if (unit_step(a, z[0].order)) {
+            run(unitstep<decltype(a.step(0))>);
         } else {
-            return (subply<order, rank-1, 1>(a, a.len(order[0]), ss0, early)).value_or(early);
+            run(a.step(z[0].order));
         }
+        reduce_tree(part, combine);
+        c = std::move(part[0]);
     }
 }
 
-// defaults.
+constexpr void
+par_reduce(par_t const & p, auto & c, auto && k, auto && combine, auto && ... a)
+{
+    reduce_blocks(p, c, c, RA_FW(k), combine, combine, combine, std::numeric_limits<dim_t>::max(), RA_FW(a) ...);
+}
 
-template <class Early = none_t>
-constexpr auto
-ply(Iterator auto && a, Early const & early = none)
+// --------------------
+// Traversal plan, for inspection.
+// --------------------
+
+struct Plan
 {
-    if constexpr (ANY==size_s(a)) {
-        return ply_ravel(RA_FW(a), early);
+    std::string plyer;
+    rank_t rank = 0;
+    dim_t size = 0;
+    bool rank_static = false, size_static = false;
+    int check = 2; // cf Match::check_s
+    std::vector<rank_t> order; // outer to inner
+    std::vector<dim_t> lens;
+    std::vector<bool> lens_static;
+    std::vector<std::vector<dim_t>> steps; // for each axis in order, for each leaf
+    rank_t loops = 0; // after raveling
+    dim_t ss = 0; // length of the inner loop after raveling
+    bool unit = false, unroll = false;
+};
+
+constexpr void
+flat_steps(auto const & s, std::vector<dim_t> & v)
+{
+    if constexpr (requires { []<class ... T>(std::tuple<T ...> const &){}(s); }) {
+        std::apply([&v](auto const & ... s){ (flat_steps(s, v), ...); }, s);
     } else {
-        return ply_fixed(RA_FW(a), early);
+        v.push_back(dim_t(s));
     }
 }
 
-constexpr void for_each(auto && op, auto && ... a) { ply(map(RA_FW(op), RA_FW(a) ...)); }
-constexpr auto early(Iterator auto && a, auto const & def) { return ply(RA_FW(a), def); }
+// The plan that ply(e, none, order) would use.
+template <class Order = none_t>
+inline Plan
+explain(auto && e, Order const & order = none)
+{
+    auto a = iter(RA_FW(e));
+    using A = std::decay_t<decltype(a)>;
+    validate(a);
+    Plan p;
+    p.rank = ra::rank(a);
+    p.size = ra::size(a);
+    p.rank_static = ANY!=rank_s<A>();
+    p.size_static = ANY!=size_s<A>();
+    if constexpr (is_match<A>) {
+        p.check = A::check_s();
+    }
+    if (0==p.rank) {
+        p.plyer = ANY==size_s<A>() ? "ply_ravel" : "ply_fixed";
+        p.ss = 1;
+        return p;
+    }
+    if constexpr (ANY!=size_s<A>()) {
+        constexpr rank_t rank = rank_s<A>();
+        constexpr auto o = ply_order_s<A, none_t, Order>();
+        constexpr auto rs = ply_ravel_s<A, o>;
+        p.plyer = "ply_fixed";
+        for (rank_t i=rank-1; i>=0; --i) { p.order.push_back(o[i]); }
+        p.loops = rank-rs.first+1;
+        p.ss = rs.second;
+        p.unit = ply_unit_s<A, o[0]> || unit_step(a, o[0]);
+        p.unroll = size_s<A>()<=RA_UNROLL;
+    } else {
+        p.plyer = "ply_ravel";
+        ply_axes z(p.rank);
+        ply_order(a, z.data(), p.rank, order);
+        for (rank_t i=p.rank-1; i>=0; --i) { p.order.push_back(z[i].order); }
+        p.loops = ply_plan(a, z.data(), p.rank, order)+1;
+        p.ss = z[0].len;
+        p.unit = unit_step(a, z[0].order);
+    }
+    for (rank_t k: p.order) {
+        p.lens.push_back(a.len(k));
+        p.lens_static.push_back(ANY!=A::len_s(k));
+        flat_steps(a.step(k), p.steps.emplace_back());
+    }
+    return p;
+}
+
+inline std::ostream &
+operator<<(std::ostream & o, Plan const & p)
+{
+    std::print(o, "{} rank {} ({}) size {} ({}) check_s {} loops {} ss {}{}{}\n", p.plyer,
+               p.rank, p.rank_static ? "static" : "dynamic", p.size, p.size_static ? "static" : "dynamic", p.check,
+               p.loops, p.ss, p.unit ? " unit step" : "", p.unroll ? " unrolled" : "");
+    std::print(o, "axis len static steps");
+    for (size_t i=0; i<p.order.size(); ++i) {
+        std::print(o, "\n{:4} {:3} {:6}", p.order[i], p.lens[i], p.lens_static[i] ? "yes" : "no");
+        for (dim_t s: p.steps[i]) { std::print(o, " {}", s); }
+    }
+    return o;
+}
 
-
 // --------------------
 // Input/'output' iterator adapter. FIXME maybe random for rank 1?
 // --------------------
@@ -498,6 +2630,104 @@ fromu(auto && b, auto && ds, auto && c, auto && ti, auto && i0, auto && ... i)
     }
 }
 
+// View ops on expressions are beaten down to the leaves, where they become view ops on the arrays. The leaves must be Cells
+// with rank 0 cells, possibly under a Reframe, or rank 0 Iterators, which are left alone.
+
+template <class P, class Dimv, class Cr>
+constexpr auto
+cellview(Cell<P, Dimv, Cr> const & a)
+{
+    constexpr rank_t cellr = Cell<P, Dimv, Cr>::cellr;
+    static_assert(0==cellr || ANY==cellr, "Cannot beat view op into cell of rank > 0.");
+    if constexpr (ANY==cellr) {
+        RA_CK(0==ra::size(a.c.dimv), "Cannot beat view op into cell of rank ", ra::size(a.c.dimv), ".");
+    }
+    if constexpr (is_ctype<Dimv>) {
+        return View<P, Dimv>(a.c.cp);
+    } else {
+        return View<P, Dimv>(a.dimv, a.c.cp);
+    }
+}
+
+template <class B, int ... di, class I>
+constexpr auto
+cellview(Reframe<B, ilist_t<di ...>, I> const & a)
+{
+    static_assert(is_cell<B>, "Cannot beat view op into Reframe of expression.");
+    return transpose(cellview(a.a), ilist<di ...>);
+}
+
+// Rebuild Map or Pick a with children f(child).
+template <class Op, class ... P, class K>
+constexpr auto
+beat_children(Map<Op, std::tuple<P ...>, K> const & a, auto && f)
+{
+    return std::apply([&](auto const & ... p){ return Map<Op, std::tuple<decltype(f(p)) ...>>(a.op, f(p) ...); }, a.t);
+}
+
+template <class ... P, class K>
+constexpr auto
+beat_children(Pick<std::tuple<P ...>, K> const & a, auto && f)
+{
+    return std::apply([&](auto const & ... p){ return Pick<std::tuple<decltype(f(p)) ...>>(f(p) ...); }, a.t);
+}
+
+template <class I> constexpr int fsrc_s = 1;
+template <int n> constexpr int fsrc_s<dots_t<n>> = n;
+template <int n> constexpr int fsrc_s<insert_t<n>> = 0;
+
+// Leaves of rank r take subscripts until they have used up r axes, so each leaf gives a prefix of the axes of the result.
+template <rank_t r, class ... I>
+constexpr int fromtake_s = []{
+    static_assert(((0==fsrc_s<I> || 1==fsrc_s<I>) && ...), "Cannot beat multiple dots into expression.");
+    std::array<int, sizeof...(I)> s = { fsrc_s<I> ... };
+    int n = 0;
+    for (int c=0; n<int(sizeof...(I)) && c<r; ++n) { c += s[n]; }
+    return n;
+}();
+
+constexpr auto
+from_beaten(auto const & a, auto const & ... i)
+{
+    using A = std::decay_t<decltype(a)>;
+    if constexpr (is_cell<A> || is_reframe<A>) {
+        decltype(auto) b = from(cellview(a), i ...);
+        if constexpr (Slice<decltype(b)>) {
+            return iter(std::move(b));
+        } else if constexpr (Iterator<decltype(b)>) {
+            return b;
+        } else {
+            return ra::scalar(RA_FW(b));
+        }
+    } else if constexpr (is_match<A>) {
+        return beat_children(a, [&](auto const & p){
+            constexpr rank_t r = rank_s<decltype(p)>();
+            static_assert(ANY!=r, "Cannot beat subscripts into leaf of dynamic rank.");
+            return [&]<int ... k>(ilist_t<k ...>){
+                return from_beaten(p, std::get<k>(std::tie(i ...)) ...);
+            }(mp::iota<fromtake_s<r, std::decay_t<decltype(i)> ...>> {});
+        });
+    } else {
+        static_assert(0==sizeof...(i), "Cannot beat subscripts into expression.");
+        return a;
+    }
+}
+
+constexpr auto
+gather(auto && a, auto && i)
+{
+    return map(gather_t<decltype(a.data()), 1> { a.data(), { a.step(0) }, { a.len(0) } }, RA_FW(i));
+}
+
+constexpr auto
+gather(auto && a, auto && i, auto && j)
+{
+    return map(gather_t<decltype(a.data()), 2> { a.data(), { a.step(0), a.step(1) }, { a.len(0), a.len(1) } },
+               RA_FW(i), reframe(iter(RA_FW(j)), ilist<1>));
+}
+
+template <class I> concept gather_index = 1==rank_s<I>() && !has_len<I> && std::is_integral_v<ncvalue_t<I>> && !std::is_same_v<bool, ncvalue_t<I>>;
+
 // only forward to unbeaten part. Not all var rank cases are handled.
 
 template <class A>
@@ -506,7 +2736,10 @@ from(A && a, auto && ...  i)
 {
     if constexpr (Slice<decltype(a)>) {
         constexpr int dsn = (0 + ... + int(!beatable(i)));
-        if constexpr (constexpr int bn=frombrank_s(a, i ...); 0==bn) {
+        if constexpr (std::is_lvalue_reference_v<A> && dsn==sizeof...(i) && (1==dsn || 2==dsn) && dsn==rank_s<A>()
+                      && (gather_index<decltype(i)> && ...)) {
+            return gather(a, RA_FW(i) ...);
+        } else if constexpr (constexpr int bn=frombrank_s(a, i ...); 0==bn) {
             return *frompl(a.data(), a, i ...);
         } else if constexpr (ANY!=bn) {
             auto beaten = [&]{
@@ -543,6 +2776,8 @@ from(A && a, auto && ...  i)
             return fromu(std::move(b), ic<[]<class ... I>(list<I ...>){ return std::array { int(I{}) ... }; }(mp::iota<dsn> {})>,
                          ic<0>, std::tuple<> {}, RA_FW(i) ...);
         }
+    } else if constexpr (Iterator<A>) {
+        return from_beaten(a, i ...);
     } else if constexpr (0==sizeof...(i)) { // map(op) isn't defined
         return RA_FW(a)();
     } else {
@@ -142,6 +142,108 @@ RA_BINOP_I(std::multiplies<>, seqvop, seqv1 , ra::iota(RAI(1).dimv[0].len, RAI(0
 template <seqv1 I> constexpr auto
 opt(Map<std::negate<>, std::tuple<I>> && e) { return ra::iota(RAI(0).dimv[0].len, -RAI(0).c.cp.i, csub(ic<0>, RAI(0).dimv[0].step)); }
 
+// Iotas of other ranks, and reframed iotas such as ra::_1, are also affine in the index, and they fold into a ViewBig over Seq.
+template <class X> concept seqcell = requires (X a) { []<class I, class Dimv>(Cell<Seq<I>, Dimv, ic_t<0>> const &){}(a); };
+template <class X> concept seqv = (!has_len<X> && 0<rank_s<X>()
+                                   && (seqcell<X> || (is_reframe<X> && seqcell<std::decay_t<decltype(std::declval<X>().a)>>)));
+template <class X> concept seqvn = seqv<X> && !seqv1<X>;
+
+// origin and dims of x, with dead axes up to rank R.
+template <rank_t R>
+constexpr auto
+seqdims(auto const & x)
+{
+    auto v = cellview(x);
+    std::array<Dim, R> d;
+    for (int k=0; k<R; ++k) { d[k] = k<ra::rank(v) ? Dim { v.len(k), v.step(k) } : Dim { UNB, 0 }; }
+    return std::make_pair(v.cp.i, d);
+}
+
+template <rank_t R, class T>
+constexpr auto
+seqview(T o, std::array<Dim, R> const & d) { return ViewBig<Seq<T>, R>(d, Seq<T> {o}); }
+
+constexpr auto
+seqv_op(auto && op, auto const & x, auto const & y)
+{
+    constexpr rank_t R = std::max(rank_s(x), rank_s(y));
+    auto [ox, dx] = seqdims<R>(x);
+    auto [oy, dy] = seqdims<R>(y);
+    for (int k=0; k<R; ++k) {
+        RA_CK(UNB==dx[k].len || UNB==dy[k].len || dx[k].len==dy[k].len, "Mismatched lengths ", dx[k].len, " ", dy[k].len, " on axis ", k, ".");
+        dx[k] = Dim { UNB==dx[k].len ? dy[k].len : dx[k].len, op(dx[k].step, dy[k].step) };
+    }
+    return seqview<R>(op(ox, oy), dx);
+}
+
+constexpr auto
+seqv_scalar(auto && fo, auto && fs, auto const & x)
+{
+    constexpr rank_t R = rank_s(x);
+    auto [o, d] = seqdims<R>(x);
+    for (auto & dk: d) { dk.step = fs(dk.step); }
+    return seqview<R>(fo(o), d);
+}
+
+template <seqv I, seqv J> requires (seqvn<I> || seqvn<J>) constexpr auto
+opt(Map<std::plus<>, std::tuple<I, J>> && e) { return seqv_op(std::plus<> {}, RAI(0), RAI(1)); }
+template <seqv I, seqv J> requires (seqvn<I> || seqvn<J>) constexpr auto
+opt(Map<std::minus<>, std::tuple<I, J>> && e) { return seqv_op(std::minus<> {}, RAI(0), RAI(1)); }
+template <seqvn I, seqvop J> constexpr auto
+opt(Map<std::plus<>, std::tuple<I, J>> && e) { return seqv_scalar([&](auto o){ return o+*RAI(1); }, std::identity {}, RAI(0)); }
+template <seqvop I, seqvn J> constexpr auto
+opt(Map<std::plus<>, std::tuple<I, J>> && e) { return seqv_scalar([&](auto o){ return *RAI(0)+o; }, std::identity {}, RAI(1)); }
+template <seqvn I, seqvop J> constexpr auto
+opt(Map<std::minus<>, std::tuple<I, J>> && e) { return seqv_scalar([&](auto o){ return o-*RAI(1); }, std::identity {}, RAI(0)); }
+template <seqvop I, seqvn J> constexpr auto
+opt(Map<std::minus<>, std::tuple<I, J>> && e) { return seqv_scalar([&](auto o){ return *RAI(0)-o; }, std::negate<> {}, RAI(1)); }
+template <seqvn I, seqvop J> constexpr auto
+opt(Map<std::multiplies<>, std::tuple<I, J>> && e) { return seqv_scalar([&](auto o){ return o*(*RAI(1)); }, [&](dim_t s){ return s*(*RAI(1)); }, RAI(0)); }
+template <seqvop I, seqvn J> constexpr auto
+opt(Map<std::multiplies<>, std::tuple<I, J>> && e) { return seqv_scalar([&](auto o){ return (*RAI(0))*o; }, [&](dim_t s){ return (*RAI(0))*s; }, RAI(1)); }
+template <seqvn I> constexpr auto
+opt(Map<std::negate<>, std::tuple<I>> && e) { return seqv_scalar(std::negate<> {}, std::negate<> {}, RAI(0)); }
+
+// Sum of affine x, which must be bounded.
+constexpr auto
+seqv_sum(auto const & x)
+{
+    constexpr rank_t R = rank_s(x);
+    auto [o, d] = seqdims<R>(x);
+    dim_t n = 1;
+    for (auto const & dk: d) { RA_CK(UNB!=dk.len, "Cannot reduce unbounded iota."); n *= dk.len; }
+    auto s = o*n;
+    for (auto const & dk: d) { if (dk.len>0) { s += dk.step*((n/dk.len)*(dk.len*(dk.len-1)/2)); } }
+    return s;
+}
+
+// Constant folding. Scalars holding references aren't folded, since the referenced value may change before the expression is used.
+// Only scalar types are folded, since an op on arrays may return an expression that refers to the arguments of e.
+template <class Op, class ... C> requires (0<sizeof...(C) && ((!std::is_reference_v<C> && is_scalar<C>) && ...)) constexpr auto
+opt(Map<Op, std::tuple<Scalar<C> ...>> && e) { return ra::scalar(std::apply([&e](auto const & ... c){ return std::invoke(e.op, c.c ...); }, e.t)); }
+
+// a*b+c and c+a*b as fma.
+#if defined(RA_FMA)
+#elif defined(FP_FAST_FMA)
+  #define RA_FMA FP_FAST_FMA
+#else
+  #define RA_FMA 0
+#endif
+
+struct fma_t { constexpr static auto operator()(auto const & a, auto const & b, auto const & c) { return std::fma(a, b, c); } };
+template <class ... X> constexpr bool fmable = RA_FMA && (std::is_floating_point_v<ncvalue_t<X>> && ...);
+
+template <class A, class B, class C, class K> requires (fmable<A, B, C>) constexpr auto
+opt(Map<std::plus<>, std::tuple<Map<std::multiplies<>, std::tuple<A, B>, K>, C>> && e)
+{
+    return Map(fma_t {}, std::move(get<0>(RAI(0).t)), std::move(get<1>(RAI(0).t)), std::move(RAI(1)));
+}
+template <class A, class B, class C, class K> requires (fmable<A, B, C>) constexpr auto
+opt(Map<std::plus<>, std::tuple<C, Map<std::multiplies<>, std::tuple<A, B>, K>>> && e)
+{
+    return Map(fma_t {}, std::move(get<0>(RAI(1).t)), std::move(get<1>(RAI(1).t)), std::move(RAI(0)));
+}
+
 #if RA_OPT_SMALL==1
 template <class T, dim_t N, class A> constexpr bool match_small =
     std::is_same_v<std::decay_t<A>, Cell<T *, ic_t<std::array {Dim(N, 1)}>, ic_t<0>>>
@@ -276,26 +378,116 @@ operator ||(A && a, B && b) { return VAL(a) || VAL(b);  }
 // Whole-array ops. TODO First/variable rank reductions? FIXME C++23 and_then/or_else/etc
 // --------------------------------
 
+// The versions with par_t argument may run in parallel, see ply_find().
+
 constexpr bool
-any(auto && a)
+any(par_t const & p, auto && a)
 {
-    return early(map([](bool x){ return x ? std::make_optional(true) : std::nullopt; }, RA_FW(a)), false);
+    if consteval {
+        return early(map([](bool x){ return x ? std::make_optional(true) : std::nullopt; }, RA_FW(a)), false);
+    } else {
+        return 0<=ply_find<false>(p, map([](bool x){ return x; }, RA_FW(a)));
+    }
 }
 
 constexpr bool
-every(auto && a)
+every(par_t const & p, auto && a)
 {
-    return early(map([](bool x){ return !x ? std::make_optional(false) : std::nullopt; }, RA_FW(a)), true);
+    if consteval {
+        return early(map([](bool x){ return !x ? std::make_optional(false) : std::nullopt; }, RA_FW(a)), true);
+    } else {
+        return 0>ply_find<false>(p, map([](bool x){ return !x; }, RA_FW(a)));
+    }
 }
 
 // FIXME only returns 1st index. Variable rank? see J 'index of' (x i. y), etc.
 constexpr dim_t
-index(auto && a)
+index(par_t const & p, auto && a)
+{
+    if consteval {
+        return early(map([](auto && a, auto && i){ return a ? std::make_optional(i) : std::nullopt; }, RA_FW(a), ra::iota()),
+                     ra::dim_t(-1));
+    } else {
+        auto e = map([](bool x){ return x; }, RA_FW(a));
+        dim_t i = ply_find(p, e);
+        return 0<=i && 0<rank(e) ? i/(size(e)/e.len(0)) : i;
+    }
+}
+
+constexpr bool any(auto && a) { return any(seq, RA_FW(a)); }
+constexpr bool every(auto && a) { return every(seq, RA_FW(a)); }
+constexpr dim_t index(auto && a) { return index(seq, RA_FW(a)); }
+
+// Selection by mask, in row major order. The true elements of each block along axis 0 are counted first, so the result
+// is sized once by make(n) and the blocks are written in parallel by put(o, j, e, z). mask is the first child of e.
+inline auto
+compress_(par_t const & p, auto && e, auto && make, auto && put)
 {
-    return early(map([](auto && a, auto && i){ return a ? std::make_optional(i) : std::nullopt; }, RA_FW(a), ra::iota()),
-                 ra::dim_t(-1));
+    validate(e);
+    auto sel = [](auto const & e) -> bool { return *get<0>(e.t); };
+    if (0==ra::rank(e)) {
+        auto o = make(dim_t(sel(e)));
+        if (sel(e)) {
+            put(o, 0, e, ply_axes(0));
+        }
+        return o;
+    }
+    dim_t len = e.len(0);
+    int nt = par_nthreads(p, ra::size(e), len);
+    std::vector<dim_t> c(nt+1, 0);
+    par_run(nt, [&](int t){
+        auto ta = e;
+        dim_t n = 0;
+        ply_rows(ta, par_begin(len, t, nt), par_begin(len, t+1, nt), [&n, &sel](auto const & a, auto const &){ n += sel(a); });
+        c[t+1] = n;
+    }, p.pin);
+    for (int t=0; t<nt; ++t) { c[t+1] += c[t]; }
+    auto o = make(c[nt]);
+    par_run(nt, [&](int t){
+        auto ta = e;
+        dim_t j = c[t];
+        ply_rows(ta, par_begin(len, t, nt), par_begin(len, t+1, nt),
+                 [&](auto const & a, auto const & z){ if (sel(a)) { put(o, j++, a, z); } });
+    }, p.pin);
+    return o;
 }
 
+// Elements of a where mask is true, as a rank 1 array. mask and a are matched as in map().
+constexpr auto
+compress(par_t const & p, auto && mask, auto && a)
+{
+    using T = ncvalue_t<decltype(a)>;
+    return compress_(p, map([](bool m, auto &&){ return m; }, RA_FW(mask), RA_FW(a)),
+                     [](dim_t n){ return Big<T, 1>({n}, none); },
+                     [](auto & o, dim_t j, auto const & a, auto const &){ o.data()[j] = *get<1>(a.t); });
+}
+
+// Indices of the true elements of mask. For rank 1, a rank 1 array of indices, else a rank 2 array with an index per row.
+// If the rank of mask is only known at runtime, so is the rank of the result.
+constexpr auto
+nonzero(par_t const & p, auto && mask)
+{
+    auto e = map([](bool m){ return m; }, RA_FW(mask));
+    if constexpr (1==rank_s(e)) {
+        return compress_(p, std::move(e), [](dim_t n){ return Big<dim_t, 1>({n}, none); },
+                         [](auto & o, dim_t j, auto const &, auto const & z){ o.data()[j] = z[0].ind; });
+    } else {
+        rank_t r = ra::rank(e);
+        auto put = [r](auto & o, dim_t j, auto const &, auto const & z){
+            for (rank_t k=0; k<r; ++k) { o.data()[j*r+k] = z[k].ind; }
+        };
+        if constexpr (ANY==rank_s(e)) {
+            return compress_(p, std::move(e), [r](dim_t n){ return 1==r ? Big<dim_t>({n}, none) : Big<dim_t>({n, dim_t(r)}, none); },
+                             put);
+        } else {
+            return compress_(p, std::move(e), [r](dim_t n){ return Big<dim_t, 2>({n, dim_t(r)}, none); }, put);
+        }
+    }
+}
+
+constexpr auto compress(auto && mask, auto && a) { return compress(seq, RA_FW(mask), RA_FW(a)); }
+constexpr auto nonzero(auto && mask) { return nonzero(seq, RA_FW(mask)); }
+
 constexpr bool
 lexical_compare(auto && a, auto && b)
 {
@@ -303,24 +495,31 @@ lexical_compare(auto && a, auto && b)
                  false);
 }
 
+// The reductions with par_t argument may run in parallel, see par_reduce().
+
 constexpr auto
-amin(auto && a)
+amin(par_t const & p, auto && a)
 {
     using T = ncvalue_t<decltype(a)>;
     T c = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
-    for_each([&c](auto && a){ if (a<c) { c=a; } }, RA_FW(a));
+    constexpr auto f = [](auto & c, auto && a){ if (a<c) { c=a; } };
+    par_reduce(p, c, f, f, RA_FW(a));
     return c;
 }
 
 constexpr auto
-amax(auto && a)
+amax(par_t const & p, auto && a)
 {
     using T = ncvalue_t<decltype(a)>;
     T c = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
-    for_each([&c](auto && a){ if (c<a) { c=a; } }, RA_FW(a));
+    constexpr auto f = [](auto & c, auto && a){ if (c<a) { c=a; } };
+    par_reduce(p, c, f, f, RA_FW(a));
     return c;
 }
 
+constexpr auto amin(auto && a) { return amin(seq, RA_FW(a)); }
+constexpr auto amax(auto && a) { return amax(seq, RA_FW(a)); }
+
 // FIXME encapsulate this kind of reference-reduction.
 // FIXME ply doesn't allow partial iteration (adv then continue).
 template <class A, class Less = std::less<ncvalue_t<A>>>
@@ -346,27 +545,29 @@ refmax(A && a, Less && less = {})
 }
 
 constexpr auto
-sum(auto && a)
+sum(par_t const & p, auto && a)
 {
-    auto c = copy_shape(VAL(a), ncvalue_t<decltype(VAL(a))>(0));
-    for_each([&c](auto && a){ c+=a; }, RA_FW(a));
-    return c;
+    if constexpr (seqv<decltype(iter(a))> && std::is_integral_v<ncvalue_t<decltype(a)>>) {
+        return ncvalue_t<decltype(a)>(seqv_sum(iter(a)));
+    } else {
+        auto c = copy_shape(VAL(a), ncvalue_t<decltype(VAL(a))>(0));
+        constexpr auto f = [](auto & c, auto && a){ c+=a; };
+        par_reduce(p, c, f, f, RA_FW(a));
+        return c;
+    }
 }
 
 constexpr auto
-prod(auto && a)
+prod(par_t const & p, auto && a)
 {
     auto c = copy_shape(VAL(a), ncvalue_t<decltype(VAL(a))>(1));
-    for_each([&c](auto && a){ c*=a; }, RA_FW(a));
+    constexpr auto f = [](auto & c, auto && a){ c*=a; };
+    par_reduce(p, c, f, f, RA_FW(a));
     return c;
 }
 
-#if defined(RA_FMA)
-#elif defined(FP_FAST_FMA)
-  #define RA_FMA FP_FAST_FMA
-#else
-  #define RA_FMA 0
-#endif
+constexpr auto sum(auto && a) { return sum(seq, RA_FW(a)); }
+constexpr auto prod(auto && a) { return prod(seq, RA_FW(a)); }
 
 // FIXME tends to be slower, should par/simd before (see ply).
 constexpr void maybe_fma(auto && a, auto && b, auto && c) { if constexpr (RA_FMA) c=fma(a, b, c); else c+=a*b; }
@@ -377,29 +578,160 @@ constexpr auto norm2(auto && a) { return std::sqrt(reduce_sqrm(a)); }
 constexpr auto normv(auto const & a) { auto b = concrete(a); return b /= norm2(b); }
 
 constexpr auto
-dot(auto && a, auto && b)
+dot(par_t const & p, auto && a, auto && b)
 {
     auto c = decltype(VAL(a) * VAL(b))();
-    for_each([&c](auto && a, auto && b){ maybe_fma(a, b, c); }, RA_FW(a), RA_FW(b));
+    par_reduce(p, c, [](auto & c, auto && a, auto && b){ maybe_fma(a, b, c); }, [](auto & c, auto const & d){ c+=d; },
+               RA_FW(a), RA_FW(b));
     return c;
 }
 
 constexpr auto
-cdot(auto && a, auto && b)
+cdot(par_t const & p, auto && a, auto && b)
 {
     auto c = decltype(conj(VAL(a)) * VAL(b))();
-    for_each([&c](auto && a, auto && b){ maybe_fma_conj(a, b, c); }, RA_FW(a), RA_FW(b));
+    par_reduce(p, c, [](auto & c, auto && a, auto && b){ maybe_fma_conj(a, b, c); }, [](auto & c, auto const & d){ c+=d; },
+               RA_FW(a), RA_FW(b));
     return c;
 }
 
 constexpr auto
-reduce_sqrm(auto && a)
+reduce_sqrm(par_t const & p, auto && a)
 {
     auto c = decltype(sqrm(VAL(a)))();
-    for_each([&c](auto && a){ maybe_fma_sqrm(a, c); }, RA_FW(a));
+    par_reduce(p, c, [](auto & c, auto && a){ maybe_fma_sqrm(a, c); }, [](auto & c, auto const & d){ c+=d; }, RA_FW(a));
     return c;
 }
 
+constexpr auto dot(auto && a, auto && b) { return dot(seq, RA_FW(a), RA_FW(b)); }
+constexpr auto cdot(auto && a, auto && b) { return cdot(seq, RA_FW(a), RA_FW(b)); }
+constexpr auto reduce_sqrm(auto && a) { return reduce_sqrm(seq, RA_FW(a)); }
+
+// Accumulation policies for sum, dot, reduce_sqrm, norm2. These are for scalar results only. The elements are summed plainly on the
+// lanes of reduce_blocks, and each block of elements is added to the accumulator once, so the inner loop is the same as for sum.
+// pairwise: blocks of the given size are summed by cascade [Higham 2002, §4.2].
+// kahan: compensated summation of blocks [Kahan 1965]. -ffast-math defeats it.
+// widen<W>: cast the arguments to W before operating.
+
+template <class T>
+struct pairwise_acc
+{
+    uint64_t used = 0;
+    std::array<T, 64> s {};
+    constexpr void
+    add(T x)
+    {
+        int k = 0;
+        for (; used & (uint64_t(1)<<k); ++k) { x = s[k] + x; }
+        s[k] = x;
+        ++used;
+    }
+    constexpr void merge(pairwise_acc const & d) { add(d.get()); }
+    constexpr T
+    get() const
+    {
+        T r {};
+        for (int k=0; k<64; ++k) { if (used & (uint64_t(1)<<k)) { r += s[k]; } }
+        return r;
+    }
+};
+
+template <class T>
+struct kahan_acc
+{
+    T s {}, c {};
+    constexpr void
+    add(T const & x)
+    {
+        T y = x - c;
+        T t = s + y;
+        c = (t - s) - y;
+        s = t;
+    }
+    constexpr void merge(kahan_acc const & d) { add(d.s); add(-d.c); }
+    constexpr T get() const { return s - c; }
+};
+
+template <class T>
+struct plain_acc
+{
+    T s {};
+    constexpr void add(T const & x) { s += x; }
+    constexpr void merge(plain_acc const & d) { s += d.s; }
+    constexpr T get() const { return s; }
+};
+
+struct pairwise_t
+{
+    dim_t block = 128;
+    template <class T> constexpr auto acc() const { return pairwise_acc<T> {}; }
+    constexpr static decltype(auto) cast(auto && x) { return RA_FW(x); }
+};
+
+// short blocks, since the sum within a block isn't compensated.
+struct kahan_t
+{
+    dim_t block = 4*reduce_lanes;
+    template <class T> constexpr auto acc() const { return kahan_acc<T> {}; }
+    constexpr static decltype(auto) cast(auto && x) { return RA_FW(x); }
+};
+
+template <class W>
+struct widen_t
+{
+    constexpr static dim_t block = std::numeric_limits<dim_t>::max();
+    template <class T> constexpr auto acc() const { return plain_acc<T> {}; }
+    template <class T> constexpr static std::complex<W> cast(std::complex<T> const & x) { return x; }
+    constexpr static W cast(auto const & x) { return W(x); }
+};
+
+constexpr pairwise_t pairwise {};
+constexpr kahan_t kahan {};
+template <class W=double> constexpr widen_t<W> widen {};
+
+template <class T> constexpr bool is_acc_def = false;
+template <> constexpr bool is_acc_def<pairwise_t> = true;
+template <> constexpr bool is_acc_def<kahan_t> = true;
+template <class W> constexpr bool is_acc_def<widen_t<W>> = true;
+template <class T> concept is_acc = is_acc_def<std::decay_t<T>>;
+
+constexpr auto
+acc_reduce(par_t const & p, is_acc auto const & acc, auto && term, auto && ... a)
+{
+    using A = std::decay_t<decltype(acc)>;
+    using T = std::decay_t<decltype(term(A::cast(VAL(a)) ...))>;
+    auto c = acc.template acc<T>();
+    RA_CK(0<acc.block, "Bad block ", acc.block, ".");
+    reduce_blocks(p, c, T(), [term](T & l, auto && ... a){ l += term(A::cast(RA_FW(a)) ...); },
+                  [](T & l, T const & m){ l += m; }, [](auto & c, T const & l){ c.add(l); }, [](auto & c, auto const & d){ c.merge(d); },
+                  acc.block, RA_FW(a) ...);
+    return c.get();
+}
+
+constexpr auto
+sum(par_t const & p, is_acc auto const & acc, auto && a)
+{
+    return acc_reduce(p, acc, [](auto && a){ return a; }, RA_FW(a));
+}
+
+constexpr auto
+dot(par_t const & p, is_acc auto const & acc, auto && a, auto && b)
+{
+    return acc_reduce(p, acc, [](auto && a, auto && b){ return a*b; }, RA_FW(a), RA_FW(b));
+}
+
+constexpr auto
+reduce_sqrm(par_t const & p, is_acc auto const & acc, auto && a)
+{
+    return acc_reduce(p, acc, [](auto && a){ return sqrm(a); }, RA_FW(a));
+}
+
+constexpr auto sum(is_acc auto const & acc, auto && a) { return sum(seq, acc, RA_FW(a)); }
+constexpr auto dot(is_acc auto const & acc, auto && a, auto && b) { return dot(seq, acc, RA_FW(a), RA_FW(b)); }
+constexpr auto reduce_sqrm(is_acc auto const & acc, auto && a) { return reduce_sqrm(seq, acc, RA_FW(a)); }
+constexpr auto norm2(is_acc auto const & acc, auto && a) { return std::sqrt(reduce_sqrm(acc, RA_FW(a))); }
+constexpr auto norm2(par_t const & p, is_acc auto const & acc, auto && a) { return std::sqrt(reduce_sqrm(p, acc, RA_FW(a))); }
+
 constexpr decltype(auto)
 gemm(auto const & a, auto const & b, auto && c)
 {
@@ -418,8 +750,10 @@ gemv(auto const & a, auto const & b, auto && c)
         c += a * b(insert<1>);
     } else if constexpr (Slice<decltype(c)>) {
         c(insert<1>) += transpose(a) * b;
-    } else {
+    } else if constexpr (Slice<decltype(a)>) {
         for_each([&](auto && a, auto && b) { iter(c) += a * b; }, iter<1>(transpose(a)), b);
+    } else {
+        iter(c) += a * reframe(iter(b), ilist<1>);
     }
     return RA_FW(c);
 }
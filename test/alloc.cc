@@ -0,0 +1,159 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - Allocation, alignment and padding of Big storage.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#include "ra/test.hh"
+
+using std::cout, std::endl, ra::TestRecorder;
+
+struct counting_resource: std::pmr::memory_resource
+{
+    int allocs = 0, deallocs = 0;
+    void * do_allocate(std::size_t n, std::size_t a) override { ++allocs; return std::pmr::new_delete_resource()->allocate(n, a); }
+    void do_deallocate(void * p, std::size_t n, std::size_t a) override { ++deallocs; std::pmr::new_delete_resource()->deallocate(p, n, a); }
+    bool do_is_equal(std::pmr::memory_resource const & r) const noexcept override { return this==&r; }
+};
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    tr.section("alloc_scope");
+    {
+        counting_resource r;
+        ra::Big<int, 2> c;
+        {
+            ra::alloc_scope scope(&r);
+            ra::Big<int, 2> a({3, 4}, ra::_0 - ra::_1);
+            tr.test_eq(1, r.allocs);
+            auto b = concrete(a+1);
+            tr.test_eq(2, r.allocs);
+            tr.test_eq(a+1, b);
+// c has another resource, so it gets the elements and not the memory.
+            int * p = b.data();
+            c = std::move(b);
+            tr.test(nullptr==c.store.get_allocator().r);
+            tr.test(p!=c.data());
+            tr.test_eq(a+1, c);
+// same resource, same memory.
+            ra::Big<int, 2> e({1, 1}, 0);
+            tr.test_eq(3, r.allocs);
+            p = a.data();
+            e = std::move(a);
+            tr.test(&r==e.store.get_allocator().r);
+            tr.test(p==e.data());
+        }
+        tr.test_eq(3, r.deallocs);
+// outside the scope, allocation goes to std::allocator.
+        ra::Big<int, 2> d = c;
+        tr.test(nullptr==d.store.get_allocator().r);
+        tr.test_eq(3, r.allocs);
+        tr.test_eq(c, d);
+        tr.test(nullptr==ra::alloc_resource);
+    }
+    tr.section("arena_scope");
+    {
+        counting_resource r;
+        ra::alloc_scope outer(&r);
+        {
+            ra::arena_scope arena(1<<12);
+            tr.test(&arena.arena==ra::alloc_resource);
+            for (int i=0; i<100; ++i) {
+                ra::Big<double, 1> a({10}, ra::_0*i);
+                auto b = concrete(a*a);
+                tr.quiet().test_eq(ra::sqr(ra::_0*i), b);
+            }
+// arena chunks come from the enclosing scope, and are released all at once.
+            tr.test_le(1, r.allocs);
+            tr.test_eq(0, r.deallocs);
+        }
+        tr.test(&r==ra::alloc_resource);
+        tr.test_eq(r.allocs, r.deallocs);
+// nothing is left in x from the arena.
+        ra::Big<double, 1> x;
+        {
+            ra::arena_scope arena;
+            x = concrete(ra::Big<double, 1>({10}, ra::_0)*2);
+            tr.test(&r==x.store.get_allocator().r);
+        }
+        tr.test_eq(2*ra::iota(10), x);
+    }
+    tr.section("arena_scope on a buffer");
+    {
+        alignas(64) char buffer[1<<12];
+        ra::arena_scope arena(buffer, sizeof(buffer));
+        ra::Big<int, 1> a({10}, ra::_0);
+        tr.test((char *)a.data()>=buffer && (char *)(a.data()+10)<=buffer+sizeof(buffer));
+        tr.test_eq(ra::iota(10), a);
+    }
+    tr.section("pool_scope");
+    {
+        ra::pool_scope pool;
+        ra::Big<int, 1> a({100}, ra::_0);
+        int * p = a.data();
+        a = ra::Big<int, 1>();
+        ra::Big<int, 1> b({100}, 1);
+        tr.info("freed block is reused").test(p==b.data());
+        b.resize(1000);
+        tr.test_eq(1000, ra::size(b));
+        tr.test_eq(1, b(ra::iota(100)));
+    }
+    tr.section("allocator parameter");
+    {
+        using V = ra::Big<int, 1, std::allocator<int>>;
+        ra::arena_scope arena;
+        V a({10}, ra::_0);
+        tr.test_eq(ra::iota(10), a);
+        tr.test_eq(ra::iota(10), ra::Big<int, 1>(a));
+    }
+    tr.section("aligned");
+    {
+        ra::Big<double, 2, ra::scope_allocator<double, 64>> a({3, 5}, ra::_0 - ra::_1);
+        tr.test_eq(0, reinterpret_cast<std::uintptr_t>(a.data()) % 64);
+        tr.test_eq(5, a.step(0));
+        ra::Aligned<float, 1, 4096> b({10}, ra::_0);
+        tr.test_eq(0, reinterpret_cast<std::uintptr_t>(b.data()) % 4096);
+        auto c = b;
+        tr.test_eq(0, reinterpret_cast<std::uintptr_t>(c.data()) % 4096);
+        tr.test_eq(ra::iota(10), c);
+    }
+    tr.section("padded");
+    {
+        ra::Aligned<double, 2> a({3, 5}, ra::_0*10 + ra::_1);
+        tr.test_eq(8, a.step(0));
+        tr.test_eq(1, a.step(1));
+        tr.test_eq(15, ra::size(a));
+        tr.test_eq(24, ra::size(a.store));
+        for (int i=0; i<3; ++i) {
+            tr.quiet().test_eq(0, reinterpret_cast<std::uintptr_t>(a(i).data()) % 64);
+        }
+        tr.test_eq(ra::Big<double, 2>({3, 5}, ra::_0*10 + ra::_1), a);
+        tr.test(!c_order(a.dimv, false));
+        tr.test(!c_order(a.view().dimv, false));
+        a += 1;
+        tr.test_eq(ra::Big<double, 2>({3, 5}, ra::_0*10 + ra::_1 + 1), a);
+        tr.test_eq(195, sum(a));
+// ravel goes around the padding.
+        to_ravel(std::array<double, 15> { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 }, a);
+        tr.test_eq(ra::Big<double, 2>({3, 5}, ra::_0*5 + ra::_1), a);
+// rows that are already aligned aren't padded, so the array can still be raveled.
+        ra::Aligned<float, 2> b({2, 16}, ra::_0);
+        tr.test_eq(16, b.step(0));
+        tr.test(c_order(b.dimv, false));
+        tr.test_eq(ra::Big<float, 1>({32}, ra::_0/16), ravel_free(b));
+// avoid row steps that are multiples of 4K.
+        ra::Aligned<float, 2> d({2, 1024}, 0.);
+        tr.test_eq(1024 + 16, d.step(0));
+        ra::Aligned<double> e({2, 3, 3}, ra::_0*100 + ra::_1*10 + ra::_2);
+        tr.test_eq(ra::Big<int, 1> { 24, 8, 1 }, map([&](int k){ return e.step(k); }, ra::iota(3)));
+        tr.test_eq(ra::Big<double>({2, 3, 3}, ra::_0*100 + ra::_1*10 + ra::_2), e);
+        e.resize(4);
+        tr.test_eq(4*24, ra::size(e.store));
+        tr.test_eq(ra::Big<double>({2, 3, 3}, ra::_0*100 + ra::_1*10 + ra::_2), e(ra::iota(2)));
+    }
+    return tr.summary();
+}
@@ -80,5 +80,31 @@ int main()
         tr.test_eq(1, ra::index(a<0));
         tr.test_eq(-1, ra::index(a>10));
     }
+    tr.section("blocked and parallel early exit");
+    {
+        constexpr ra::par_t p4 = { .nthreads=4, .grain=1 };
+        ra::Big<int, 1> a({100000}, ra::_0);
+        for (int i: {0, 1, 255, 256, 257, 24999, 25000, 60000, 99999}) {
+            tr.info("i ", i).test_eq(i, ra::index(a>=i));
+            tr.info("i ", i).test_eq(i, ra::index(p4, a>=i));
+            tr.info("i ", i).test_eq(i, ra::index(p4, a==i));
+            tr.info("i ", i).test(ra::any(p4, a==i));
+            tr.info("i ", i).test(!ra::every(p4, a!=i));
+        }
+// first match is found even when later chunks match first.
+        tr.test_eq(30000, ra::index(p4, a==30000 || a>60000));
+        tr.test(!ra::any(p4, a<0));
+        tr.test(ra::every(p4, a>=0));
+        tr.test_eq(-1, ra::index(p4, a<0));
+        ra::Big<int, 3> b({30, 40, 50}, 0);
+        b(17, 3, 9) = 1;
+        b(29, 0, 0) = 1;
+        tr.test_eq(17, ra::index(p4, b));
+        tr.test_eq(17, ra::index(b));
+// not row-major in memory, but still the first index in row-major order.
+        tr.test_eq(0, ra::index(p4, transpose(b, {2, 1, 0})));
+        tr.test_eq(9, ra::index(p4, transpose(b(ra::iota(29)), {2, 1, 0})));
+        tr.test(!ra::any(p4, ra::Big<int, 2>({0, 4}, 1)));
+    }
     return tr.summary();
 }
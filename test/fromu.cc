@@ -200,5 +200,86 @@ int main()
         ra::Small<real, 4> a = ra::_0;
         tr.test_eq(a(ra::iota(2, 1)), Ureal<1> { 1, 2 });
     }
+    tr.section("gather/scatter");
+    {
+        ra::Big<int, 1> a({10}, 10*ra::_0);
+        ra::Big<int, 1> i = { 3, 1, 3, 9, 0 };
+        tr.test(ra::is_gather<decltype(a(i))>);
+        ra::Big<int, 1> b({5}, 0);
+        b = a(i);
+        tr.test_eq(ra::Big<int, 1> { 30, 10, 30, 90, 0 }, b);
+        b += a(i);
+        tr.test_eq(ra::Big<int, 1> { 60, 20, 60, 180, 0 }, b);
+        tr.test_eq(ra::Big<int, 1> { 30, 10, 30, 90, 0 }, a(i));
+// reversed view
+        tr.test_eq(ra::Big<int, 1> { 60, 80, 60, 0, 90 }, ra::reverse(a)(i));
+// scatter, last write wins with =, all writes apply with op=.
+        ra::Big<int, 1> c({10}, 0);
+        c(i) = ra::Big<int, 1> { 1, 2, 3, 4, 5 };
+        tr.test_eq(ra::Big<int, 1> { 5, 2, 0, 3, 0, 0, 0, 0, 0, 4 }, c);
+        c(i) += 1;
+        tr.test_eq(ra::Big<int, 1> { 6, 3, 0, 5, 0, 0, 0, 0, 0, 5 }, c);
+        c = 0;
+        c(i) += ra::Big<int, 1> { 1, 2, 3, 4, 5 };
+        tr.test_eq(ra::Big<int, 1> { 5, 2, 0, 4, 0, 0, 0, 0, 0, 4 }, c);
+// views that aren't in memory.
+        ra::ViewBig<ra::Seq<ra::dim_t>, 1> s({{10, 3}}, ra::Seq<ra::dim_t> {5});
+        tr.test_eq(ra::Big<ra::dim_t, 1> { 14, 8, 14, 32, 5 }, s(i));
+        b = s(i);
+        tr.test_eq(ra::Big<int, 1> { 14, 8, 14, 32, 5 }, b);
+        ra::ViewBig<ra::Seq<ra::dim_t>, 2> t({{4, 5}, {5, 1}}, ra::Seq<ra::dim_t> {0});
+        tr.test_eq(ra::Big<ra::dim_t, 2>({2, 3}, { 19, 19, 16, 4, 4, 1 }), t(ra::Big<int, 1> { 3, 0 }, ra::Big<int, 1> { 4, 4, 1 }));
+    }
+    tr.section("gather/scatter, 2D");
+    {
+        ra::Big<int, 2> a({4, 5}, 10*ra::_0 + ra::_1);
+        ra::Big<int, 1> i = { 3, 0 };
+        ra::Big<int, 1> j = { 4, 4, 1 };
+        tr.test(ra::is_gather<decltype(a(i, j))>);
+        tr.test_eq(ra::Big<int, 2>({2, 3}, { 34, 34, 31, 4, 4, 1 }), a(i, j));
+        tr.test_eq(ra::Big<int, 2>({3, 2}, { 34, 4, 34, 4, 31, 1 }), transpose(a)(j, i));
+        ra::Big<int, 2> b({4, 5}, 0);
+        b(i, j) += 1;
+        tr.test_eq(ra::Big<int, 2>({4, 5}, { 0, 1, 0, 0, 2,  0, 0, 0, 0, 0,  0, 0, 0, 0, 0,  0, 1, 0, 0, 2 }), b);
+    }
+    tr.section("gather/scatter with overlap");
+    {
+        ra::Big<int, 1> a = { 0, 1 };
+        ra::Big<int, 1> i = { 1, 0 };
+        a = a(i);
+        tr.test_eq(ra::Big<int, 1> { 1, 0 }, a);
+        a += a(i);
+        tr.test_eq(ra::Big<int, 1> { 1, 1 }, a);
+        ra::Big<int, 1> b = { 10, 20, 30 };
+        ra::Big<int, 1> j = { 1, 0, 2 };
+        b(j) = b;
+        tr.test_eq(ra::Big<int, 1> { 20, 10, 30 }, b);
+        b = { 0, 1, 2 };
+        ra::reverse(b) = b(ra::Big<int, 1> { 0, 1, 2 });
+        tr.test_eq(ra::Big<int, 1> { 2, 1, 0 }, b);
+// the indices themselves.
+        ra::Big<int, 1> k = { 2, 0, 1 };
+        k = k(k);
+        tr.test_eq(ra::Big<int, 1> { 1, 2, 0 }, k);
+        k = { 2, 0, 1 };
+        k(k) = ra::Big<int, 1> { 7, 8, 9 };
+        tr.test_eq(ra::Big<int, 1> { 8, 9, 7 }, k);
+    }
+    tr.section("gather/scatter, large, prefetched");
+    {
+        int n = 1<<20, m = 100000;
+        ra::Big<double, 1> a({n}, ra::_0);
+        ra::Big<int, 1> i({m}, (ra::_0*7919) % n);
+        ra::Big<double, 1> b({m}, ra::none);
+        b = a(i);
+        tr.test_eq(i, b);
+        b = -1.;
+        a(i) = b;
+        tr.test_eq(-1., a(i));
+        tr.test_eq(m, sum(ra::cast<int>(a<0.)));
+        ra::ViewBig<ra::Seq<ra::dim_t>, 1> s({{n, 1}}, ra::Seq<ra::dim_t> {0});
+        b = s(i);
+        tr.test_eq(i, b);
+    }
     return tr.summary();
 }
@@ -0,0 +1,55 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - Several statements in one traversal.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#include "ra/test.hh"
+
+using std::cout, std::endl, ra::TestRecorder;
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    tr.section("assign and reduce");
+    {
+        ra::Big<double, 1> x({10}, 0.), g({10}, ra::_0), r({10}, 1.), p({10}, 2.);
+        double t = 0.5, err = 0.;
+        ra::fused(ra::assign(x, x + t*r),
+                  ra::stmt([](auto & g, auto && p){ g -= p; }, g, t*p),
+                  ra::reduce(err, [](auto & c, auto && g){ c += ra::sqrm(g); }, g));
+        tr.test_eq(0.5, x);
+        tr.test_eq(ra::iota(10)-1., g);
+// reduce sees g after the statement before it.
+        tr.test_eq(reduce_sqrm(ra::iota(10)-1.), err);
+    }
+    tr.section("statements are run in order for each element");
+    {
+        ra::Big<int, 2> a({3, 4}, 0), b({3, 4}, 0);
+        ra::fused(ra::assign(a, ra::_0*10 + ra::_1), ra::assign(b, 2*a), ra::assign(a, a+1));
+        tr.test_eq(ra::_0*10 + ra::_1 + 1, a);
+        tr.test_eq(2*(ra::_0*10 + ra::_1), b);
+    }
+    tr.section("shapes of all the statements are agreed");
+    {
+        ra::Big<int, 2> a({3, 4}, 0);
+        ra::Big<int, 1> s({3}, 0);
+        int c = 0;
+        ra::fused(ra::assign(a, ra::_1), ra::stmt([](auto & s, auto a){ s += a; }, s, a), ra::reduce(c, [](int & c, int a){ c += a; }, a));
+        tr.test_eq(0+1+2+3, s);
+        tr.test_eq(3*(0+1+2+3), c);
+    }
+    tr.section("statements built ahead");
+    {
+        ra::Small<int, 4> a = 0, b = 0;
+        auto s0 = ra::assign(a, ra::iota(4));
+        auto s1 = ra::assign(b, a*a);
+        ra::fused(std::move(s0), std::move(s1));
+        tr.test_eq(ra::iota(4), a);
+        tr.test_eq(ra::iota(4)*ra::iota(4), b);
+    }
+    return tr.summary();
+}
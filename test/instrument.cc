@@ -0,0 +1,101 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - Traversal counters.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#define RA_INSTRUMENT 1
+#include "ra/test.hh"
+
+using std::cout, std::endl, ra::TestRecorder;
+
+auto
+find_site(std::string_view kind, std::source_location const & loc)
+{
+    for (auto const & t: ra::instrument_snapshot()) {
+        if (t.kind==kind && t.loc.line()==loc.line()) {
+            return t;
+        }
+    }
+    return ra::site_stats {};
+}
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    tr.section("counters by callsite");
+    {
+        ra::instrument_reset();
+        auto loc = std::source_location::current();
+        {
+            ra::callsite here(loc);
+            ra::Big<int, 2> a({10, 20}, ra::_0 + ra::_1);
+            ra::Big<int, 2> b({20, 10}, 0);
+            b = transpose(a);
+            ra::Small<int, 3, 4> s = 0;
+            s += 1;
+            auto c = concrete(a+1);
+            tr.test_eq(a+1, c);
+        }
+        auto t = find_site("Array", loc);
+        tr.test_eq(3, t.calls);
+        tr.test_eq(600, t.elements);
+        tr.test_eq(600*int(sizeof(int)), t.bytes);
+        tr.test_eq(0, t.planned);
+        t = find_site("ply_ravel", loc);
+        tr.test_le(3, t.calls);
+        tr.test_le(1, t.raveled);
+        tr.test_lt(t.raveled, t.planned);
+        t = find_site("ply_fixed", loc);
+        tr.test_le(1, t.calls);
+        tr.test_eq(t.planned, t.raveled);
+        tr.test_eq(12*t.calls, t.elements);
+        t = find_site("concrete", loc);
+        tr.test_eq(1, t.calls);
+        tr.test_eq(200, t.elements);
+// parallel and early exit traversals.
+        ra::instrument_reset();
+        {
+            ra::callsite here(loc);
+            ra::Big<int, 2> a({100, 30}, ra::_0 - ra::_1);
+            ra::Big<int, 2> b({100, 30}, 0);
+            ra::for_each(ra::par_t { .nthreads=4, .grain=1 }, [](auto & b, auto a){ b = a; }, b, a);
+            tr.test_eq(a, b);
+            tr.test(any(ra::par_t { .nthreads=4, .grain=1 }, b==-29));
+            ra::for_each(ra::tile_t { 8, 8 }, [](auto & b, auto a){ b = a+1; }, b, a);
+            ra::for_each(ra::omp, [](auto & b){ b = 0; }, b);
+            tr.test_eq(0, sum(ra::par_t { .nthreads=4, .grain=1 }, b));
+        }
+        t = find_site("ply_par", loc);
+        tr.test_eq(1, t.calls);
+        tr.test_eq(3000, t.elements);
+        tr.test_eq(1, t.planned);
+        t = find_site("ply_find", loc);
+        tr.test_eq(1, t.calls);
+        tr.test_eq(3000, t.elements);
+        t = find_site("ply_tiled", loc);
+        tr.test_eq(1, t.calls);
+        tr.test_eq(3000, t.elements);
+        t = find_site("ply_omp", loc);
+        tr.test_eq(1, t.calls);
+        tr.test_eq(3000, t.elements);
+        t = find_site("ply_reduce", loc);
+        tr.test_eq(1, t.calls);
+        tr.test_eq(3000, t.elements);
+// outside any ra::callsite.
+        ra::instrument_reset();
+        ra::Big<int, 1> d({7}, 0);
+        tr.test_eq(7, find_site("Array", std::source_location {}).elements);
+        int n = std::min(3, int(ra::size(ra::instrument_snapshot())));
+        tr.test_le(2, n);
+        std::ostringstream o;
+        ra::instrument_dump(o, 3);
+        tr.info(o.str()).test_eq(1+n, std::ranges::count(o.str(), '\n'));
+        ra::instrument_reset();
+        tr.test_eq(0, ra::size(ra::instrument_snapshot()));
+    }
+    return tr.summary();
+}
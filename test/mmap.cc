@@ -0,0 +1,118 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - Arrays backed by memory mapped files.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#include <filesystem>
+#include <fstream>
+#include "ra/test.hh"
+#include "ra/mmap.hh"
+
+using std::cout, std::endl, ra::TestRecorder;
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    auto path = (std::filesystem::temp_directory_path() / ("ra-test-mmap-" + std::to_string(::getpid()))).string();
+    tr.section("write mode creates the file");
+    {
+        auto a = ra::map_file<float, 3>(path, {2, 3, 4}, ra::mmap_mode::write);
+        tr.test_eq(ra::iter({2, 3, 4}), ra::shape(a));
+        a = ra::_0*100 + ra::_1*10 + ra::_2;
+        ra::sync(a);
+        tr.test_eq(2*3*4*int(sizeof(float)), int(std::filesystem::file_size(path)));
+    }
+    tr.section("read mode");
+    {
+        auto a = ra::map_file<float const, 3>(path, {2, 3, 4});
+        tr.test_eq(ra::Big<float, 3>({2, 3, 4}, ra::_0*100 + ra::_1*10 + ra::_2), a);
+// views without copies.
+        ra::ViewBig<float const *, 2> b = a(1);
+        tr.test(a.data()+12==b.data());
+        tr.test_eq(ra::Big<float, 2>({3, 4}, 100 + ra::_0*10 + ra::_1), b);
+        tr.test_eq(ra::iter({123, 113, 103}), a(1, ra::all, 3)(ra::iota(3, 2, -1)));
+        ra::advise(a, ra::mmap_advice::random);
+        ra::advise(a, ra::mmap_advice::willneed);
+        tr.test_eq(sum(ra::Big<float, 3>(a)), sum(a));
+// dynamic rank, with offset into the file.
+        auto c = ra::map_file<float const>(path, {3, 4}, ra::mmap_mode::read, 12*sizeof(float));
+        tr.test_eq(2, ra::rank(c));
+        tr.test_eq(a(1), c);
+    }
+    tr.section("copy mode doesn't write through");
+    {
+        auto a = ra::map_file<float, 1>(path, {24}, ra::mmap_mode::copy);
+        a += 1000;
+        tr.test_eq(1000., a[0]);
+        auto b = ra::map_file<float const, 1>(path, {24});
+        tr.test_eq(0., b[0]);
+        tr.test_eq(1000 + b, a);
+    }
+    tr.section("shared write is seen by other mappings");
+    {
+        auto a = ra::map_file<float, 2>(path, {6, 4}, ra::mmap_mode::write);
+        auto b = ra::map_file<float const, 2>(path, {6, 4});
+        a(ra::all, 0) = -1;
+        tr.test_eq(-1, b(ra::all, 0));
+        ra::sync(a, true);
+    }
+    tr.section("move and anonymous mappings");
+    {
+        ra::Mmap<int, 2> a({3, 3}, ra::_0 - ra::_1);
+        tr.test_eq(ra::Big<int, 2>({3, 3}, ra::_0 - ra::_1), a);
+        auto b = std::move(a);
+        tr.test(nullptr==a.data());
+        tr.test_eq(ra::Big<int, 2>({3, 3}, ra::_0 - ra::_1), b);
+    }
+    tr.section("huge pages");
+    {
+        ra::huge_scope huge(1<<20);
+        ra::Big<double, 2> a({1000, 1000}, ra::_0 - ra::_1);
+        tr.test_eq(0, reinterpret_cast<std::uintptr_t>(a.data()) % ra::huge_resource::page);
+        tr.test_eq(ra::_0 - ra::_1 + 0*a, a);
+        ra::Big<int, 1> b({10}, 1);
+        tr.test_eq(1, b);
+        a = ra::Big<double, 2>();
+        ra::init_par = ra::par;
+        ra::Big<float, 3> c({200, 100, 100}, 7.);
+        ra::init_par = ra::seq;
+        tr.test_eq(7., c);
+    }
+    tr.section("errors");
+    {
+        bool thrown = false;
+        try {
+            auto a = ra::map_file<float const, 1>(path, {1000});
+        } catch (std::system_error & e) {
+            thrown = true;
+        }
+        tr.info("file too short").test(thrown);
+        thrown = false;
+        try {
+            auto a = ra::map_file<float const, 1>(path + "-missing", {1});
+        } catch (std::system_error & e) {
+            thrown = true;
+        }
+        tr.info("missing file").test(thrown);
+        thrown = false;
+        try {
+            auto a = ra::map_file<float, 1>(path, {1});
+        } catch (std::system_error & e) {
+            thrown = true;
+        }
+        tr.info("read mode without const").test(thrown);
+        thrown = false;
+        try {
+            auto a = ra::map_file<float>(path, {1}, ra::mmap_mode::read);
+        } catch (std::system_error & e) {
+            thrown = true;
+        }
+        tr.info("read mode without const, dynamic rank").test(thrown);
+    }
+    std::filesystem::remove(path);
+    return tr.summary();
+}
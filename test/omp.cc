@@ -0,0 +1,79 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - OpenMP traversal. Build with -fopenmp, cf test/par.cc for the serial fallback.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#include <atomic>
+#include <stdexcept>
+#include "ra/test.hh"
+
+#ifndef _OPENMP
+#error "test/omp.cc must be built with -fopenmp."
+#endif
+
+using std::cout, std::endl, ra::TestRecorder;
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    omp_set_num_threads(4);
+    tr.section("top level");
+    {
+        ra::Big<int, 3> a({5, 6, 7}, ra::_0*100 + ra::_1*10 + ra::_2);
+        ra::Big<int, 3> c({5, 6, 7}, 0);
+        for_each(ra::omp, [](auto & c, auto a){ c = 2*a; }, c, a);
+        tr.test_eq(2*a, c);
+        ra::Big<int, 3> d({7, 6, 5}, 0);
+        for_each(ra::omp, [](auto & d, auto a){ d = a+1; }, transpose(d, {2, 1, 0}), a);
+        tr.test_eq(transpose(a, {2, 1, 0})+1, d);
+// the work is shared by the team.
+        ra::Big<int, 1> t({1000}, -1);
+        ply(ra::omp_t {.block=10}, map([](auto & t){ t = omp_get_thread_num(); }, t));
+        tr.test_eq(0, min(t));
+        tr.test_le(max(t), 3);
+        tr.info("threads used ", max(t)+1).test(omp_get_max_threads()==1 || max(t)>0);
+        bool thrown = false;
+        try {
+            for_each(ra::omp, [](auto a){ if (a==777) throw std::runtime_error("777"); }, ra::iota(1000));
+        } catch (std::runtime_error & e) {
+            thrown = true;
+        }
+        tr.test(thrown);
+    }
+    tr.section("orphaned");
+    {
+        ra::Big<int, 2> f({100, 10}, 0);
+#pragma omp parallel
+        for_each(ra::omp, [](auto & f, auto i){ f += i; }, f, ra::_0);
+        tr.test_eq(ra::_0 + 0*f, f);
+        ra::Big<int, 1> e({10000}, 0);
+#pragma omp parallel
+        ply(ra::omp_t {.block=333}, map([](auto & e, auto i){ e = i; }, e, ra::iota(10000)));
+        tr.test_eq(ra::iota(10000), e);
+    }
+    tr.section("orphaned, exception is seen by every thread of the team");
+    {
+        std::atomic<int> caught = 0, nt = 0;
+#pragma omp parallel
+        {
+#pragma omp single
+            nt = omp_get_num_threads();
+            try {
+                for_each(ra::omp, [](auto a){ if (a==777) throw std::runtime_error("777"); }, ra::iota(1000));
+            } catch (std::runtime_error & e) {
+                ++caught;
+            }
+        }
+        tr.test_eq(int(nt), int(caught));
+// the team is still usable after.
+        ra::Big<int, 1> g({1000}, 0);
+#pragma omp parallel
+        for_each(ra::omp, [](auto & g, auto i){ g = i; }, g, ra::iota(1000));
+        tr.test_eq(ra::iota(1000), g);
+    }
+    return tr.summary();
+}
@@ -0,0 +1,40 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - Check the fma rewrite of ra::opt(), cf test/optimize.cc.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#define RA_OPT // disable so we can compare with (forced) and without
+#define RA_FMA 1
+
+#include "ra/test.hh"
+
+using std::cout, std::endl, ra::TestRecorder;
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    tr.section("fma");
+    {
+        ra::Big<double, 1> a({5}, ra::_0+1), b({5}, 2), c({5}, ra::_0*0.5);
+        auto x = opt(a*b + c);
+        auto y = opt(c + a*b);
+        tr.test(std::is_same_v<ra::fma_t, std::decay_t<decltype(x.op)>>);
+        tr.test(std::is_same_v<ra::fma_t, std::decay_t<decltype(y.op)>>);
+        tr.test_eq(ra::Big<double, 1>({5}, (ra::_0+1)*2 + ra::_0*0.5), x);
+        tr.test_eq(ra::Big<double, 1>({5}, (ra::_0+1)*2 + ra::_0*0.5), y);
+        ra::Big<int, 1> i({5}, ra::_0);
+        tr.info("not for integers").test(std::is_same_v<std::plus<>, std::decay_t<decltype(opt(i*i + i).op)>>);
+    }
+    tr.section("fma rounds once");
+    {
+        double e = std::ldexp(1., -30);
+        ra::Big<double, 1> a({1}, 1.+e), c({1}, -(1.+2*e));
+        tr.test_eq(std::fma(1.+e, 1.+e, -(1.+2*e)), opt(a*a + c));
+        tr.test_eq(e*e, opt(a*a + c));
+    }
+    return tr.summary();
+}
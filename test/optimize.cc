@@ -140,6 +140,47 @@ int main()
         test(double(0));
         test(float(0));
     }
+    tr.section("iota ops, other ranks");
+    {
+        auto a = opt(opt(ra::_0*10) + ra::_1);
+        static_assert(ra::is_iota<decltype(a)>);
+        tr.test_eq(2, ra::rank(a));
+        tr.test_eq(ra::Big<int, 2>({3, 4}, ra::_0*10 + ra::_1), ra::Big<int, 2>({3, 4}, a));
+        auto b = opt(ra::iota({3, 4}) + ra::iota({3, 4}, 1, {1, 3}));
+        static_assert(ra::is_iota<decltype(b)>);
+        tr.test_eq(ra::Big<int, 2>({3, 4}, 5*ra::_0 + 4*ra::_1 + 1), b);
+        auto c = opt(-ra::iota({3, 4}));
+        static_assert(ra::is_iota<decltype(c)>);
+        tr.test_eq(ra::Big<int, 2>({3, 4}, -4*ra::_0 - ra::_1), c);
+        auto d = opt(opt(3*ra::iota({3, 4}, 1)) - 2);
+        tr.test_eq(ra::Big<int, 2>({3, 4}, 12*ra::_0 + 3*ra::_1 + 1), d);
+        auto e = opt(ra::_1 - ra::_0);
+        static_assert(ra::is_iota<decltype(e)>);
+        tr.test_eq(ra::Big<int, 2>({2, 3}, ra::_1 - ra::_0), ra::Big<int, 2>({2, 3}, e));
+    }
+    tr.section("iota reductions in closed form");
+    {
+        tr.test_eq(45, sum(ra::iota(10)));
+        tr.test_eq(66, sum(ra::iota({3, 4})));
+        tr.test_eq(5*11+2*55, sum(ra::iota(11, 5, 2)));
+        tr.test_eq(0, sum(ra::iota(0, 5)));
+        tr.test_eq(499999999500000000, sum(ra::iota(1000000000)));
+        auto f = opt(opt(5*ra::iota({3, 4})) - 2);
+        tr.test_eq(sum(ra::Big<int, 2>({3, 4}, 20*ra::_0 + 5*ra::_1 - 2)), sum(f));
+    }
+    tr.section("constant folding");
+    {
+        auto a = opt(ra::map(std::plus<>(), ra::scalar(2), ra::scalar(3)));
+        static_assert(requires { []<class C>(ra::Scalar<C> const &){}(a); });
+        tr.test_eq(5, a);
+        int x = 2;
+        auto b = opt(ra::map(std::plus<>(), ra::scalar(x), ra::scalar(3)));
+        x = 4;
+        tr.info("references aren't folded").test_eq(7, b);
+        auto c = opt(ra::map(std::plus<>(), ra::scalar(ra::Big<int, 1> {1, 2}), ra::scalar(ra::Big<int, 1> {3, 4})));
+        static_assert(!requires { []<class C>(ra::Scalar<C> const &){}(c); });
+        tr.info("arrays aren't folded").test_eq(ra::Big<int, 1> {4, 6}, *c);
+    }
 #if RA_OPT_SMALL==1
     static_assert(ra::match_small<double, 4, ra::Cell<double *, ra::ic_t<std::array {ra::Dim(4, 1)}>, ra::ic_t<0>>>);
     tr.section("small vector ops through vector extensions");
@@ -0,0 +1,187 @@
+// -*- mode: c++; coding: utf-8 -*-
+// ra-ra/test - Parallel traversal.
+
+// (c) Daniel Llorens - 2026
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3 of the License, or (at your option) any
+// later version.
+
+#include <stdexcept>
+#include "ra/test.hh"
+
+using std::cout, std::endl, ra::TestRecorder;
+
+int main()
+{
+    TestRecorder tr(std::cout);
+    constexpr ra::par_t p4 = { .nthreads=4, .grain=1 };
+    tr.section("ply_ravel");
+    {
+        ra::Big<int, 3> a({5, 6, 7}, ra::_0*100 + ra::_1*10 + ra::_2);
+        ra::Big<int, 3> c({5, 6, 7}, 0);
+        for_each(p4, [](auto & c, auto a){ c = 2*a; }, c, a);
+        tr.test_eq(2*a, c);
+        ra::Big<int, 3> d({7, 6, 5}, 0);
+// not ravelable, split outermost loop
+        for_each(p4, [](auto & d, auto a){ d = a+1; }, transpose(d, {2, 1, 0}), a);
+        tr.test_eq(transpose(a, {2, 1, 0})+1, d);
+// fewer items than threads
+        ra::Big<int, 1> e({3}, 0);
+        ply(p4, map([](auto & e, auto i){ e = i; }, e, ra::iota(3)));
+        tr.test_eq(ra::iota(3), e);
+// empty
+        ra::Big<int, 2> f({0, 3}, 0);
+        for_each(p4, [](auto & f){ f = 1; }, f);
+        tr.test_eq(0, ra::size(f));
+    }
+    tr.section("ply_ravel, dynamic rank");
+    {
+        ra::Big<int> a({4, 3, 2}, ra::_0*100 + ra::_1*10 + ra::_2);
+        ra::Big<int> c({4, 3, 2}, 0);
+        for_each(p4, [](auto & c, auto a){ c = a; }, c, a);
+        tr.test_eq(a, c);
+    }
+    tr.section("ply_fixed");
+    {
+        ra::Small<int, 5, 6, 2> a = ra::_0*100 + ra::_1*10 + ra::_2;
+        ra::Small<int, 5, 6, 2> c = 0;
+        for_each(p4, [](auto & c, auto a){ c = -a; }, c, a);
+        tr.test_eq(-a, c);
+        ra::Small<int, 7> b = 0;
+        for_each(p4, [](auto & b, auto i){ b = i; }, b, ra::iota(ra::ic<7>));
+        tr.test_eq(ra::iota(7), b);
+    }
+    tr.section("exceptions are rethrown");
+    {
+        ra::Big<int, 1> a({1000}, ra::_0);
+        bool thrown = false;
+        try {
+            for_each(p4, [](auto a){ if (a==777) throw std::runtime_error("777"); }, a);
+        } catch (std::runtime_error & e) {
+            thrown = true;
+        }
+        tr.test(thrown);
+    }
+    tr.section("reductions");
+    {
+        ra::Big<int, 2> a({100, 30}, ra::_0 - ra::_1);
+        ra::Big<double, 2> b({100, 30}, ra::_1 - 2*ra::_0);
+        tr.test_eq(sum(a), sum(p4, a));
+        tr.test_eq(prod(ra::iota(10, 1)), prod(p4, ra::iota(10, 1)));
+        tr.test_eq(99, amax(p4, a));
+        tr.test_eq(-198, amin(p4, b));
+        tr.test_eq(dot(a, b), dot(p4, a, b));
+        tr.test_eq(reduce_sqrm(b), reduce_sqrm(p4, b));
+        ra::Big<std::complex<double>, 1> c({1000}, ra::_0*ra::xi(1.));
+        tr.test_eq(cdot(c, c), cdot(p4, c, c));
+        tr.test_eq(0, sum(p4, ra::Big<int, 1>({0}, 0)));
+        ra::Small<int, 4, 5> s = ra::_0 + ra::_1;
+        tr.test_eq(sum(s), sum(p4, s));
+    }
+    tr.section("reductions are reproducible for a given number of threads");
+    {
+        ra::Big<double, 1> a({100001}, 1./(ra::_0+1));
+        double s0 = sum(p4, a);
+        tr.test_rel(sum(a), s0, 1e-13);
+        for (int i=0; i<10; ++i) {
+            tr.info("run ", i).test_eq(s0, sum(p4, a));
+        }
+        double d0 = dot(p4, a, a);
+        tr.test_eq(d0, dot(p4, a, a));
+        tr.test_rel(dot(a, a), d0, 1e-13);
+    }
+    tr.section("pool");
+    {
+        ra::set_num_threads(3);
+        tr.test_eq(3, ra::get_num_threads());
+        tr.test_eq(3, ra::par_nthreads(ra::par, 1<<30, 100));
+        {
+            ra::num_threads_scope scope(2);
+            tr.test_eq(2, ra::par_nthreads(ra::par, 1<<30, 100));
+            tr.test_eq(2, ra::par_nthreads(p4, 1<<30, 100));
+        }
+        tr.test_eq(4, ra::par_nthreads(p4, 1<<30, 100));
+// nested regions run serially.
+        ra::Big<int, 1> a({100}, ra::_0);
+        ra::Big<int, 1> c({50}, 0);
+        ra::Big<int, 1> n({50}, 0);
+        for_each(p4, [&](auto & c, auto & n){ c = sum(p4, a); n = ra::par_nthreads(p4, 100, 100); }, c, n);
+        tr.test_eq(99*100/2, c);
+        tr.test_eq(1, n);
+        ra::set_num_threads(0);
+        tr.test_eq(int(std::max(1u, std::thread::hardware_concurrency())), ra::get_num_threads());
+    }
+    tr.section("omp");
+    {
+        ra::Big<int, 3> a({5, 6, 7}, ra::_0*100 + ra::_1*10 + ra::_2);
+        ra::Big<int, 3> c({5, 6, 7}, 0);
+        for_each(ra::omp, [](auto & c, auto a){ c = 2*a; }, c, a);
+        tr.test_eq(2*a, c);
+        ra::Big<int, 3> d({7, 6, 5}, 0);
+        for_each(ra::omp, [](auto & d, auto a){ d = a+1; }, transpose(d, {2, 1, 0}), a);
+        tr.test_eq(transpose(a, {2, 1, 0})+1, d);
+// ravels to a single loop, which is split in blocks.
+        ra::Big<int, 1> e({10000}, 0);
+        ply(ra::omp_t {.block=333}, map([](auto & e, auto i){ e = i; }, e, ra::iota(10000)));
+        tr.test_eq(ra::iota(10000), e);
+        ra::Small<int, 3, 4> s = 0;
+        for_each(ra::omp, [](auto & s, auto i){ s = i; }, s, ra::_0 - ra::_1);
+        tr.test_eq(ra::Small<int, 3, 4>(ra::_0 - ra::_1), s);
+        for_each(ra::omp, [](auto & f){ f = 1; }, ra::Big<int, 2>({0, 3}, 0));
+        bool thrown = false;
+        try {
+            for_each(ra::omp, [](auto a){ if (a==777) throw std::runtime_error("777"); }, ra::iota(1000));
+        } catch (std::runtime_error & e) {
+            thrown = true;
+        }
+        tr.test(thrown);
+#ifdef _OPENMP
+// from inside a parallel region.
+        ra::Big<int, 2> f({100, 10}, 0);
+#pragma omp parallel
+        for_each(ra::omp, [](auto & f, auto i){ f += i; }, f, ra::_0);
+        tr.test_eq(ra::_0 + 0*f, f);
+#endif
+    }
+    tr.section("first touch");
+    {
+        ra::init_par = p4;
+        ra::Big<int, 2> a({400, 300}, ra::_0*1000 + ra::_1);
+        tr.test_eq(ra::_0*1000 + ra::_1 + 0*a, a);
+        ra::Big<double> z({10, 10000}, 0.);
+        tr.test_eq(0., z);
+        tr.test_eq(1, ra::assign_par.nthreads);
+        bool thrown = false;
+        try {
+            ra::Big<int, 1> b({1000}, map([](int i){ if (i==777) throw std::runtime_error("777"); return i; }, ra::iota(1000)));
+        } catch (std::runtime_error & e) {
+            thrown = true;
+        }
+        tr.test(thrown);
+        tr.test_eq(1, ra::assign_par.nthreads);
+        ra::init_par = ra::seq;
+// pinned chunks run on the same thread every time.
+        std::vector<std::thread::id> id0(400), id1(400);
+        ra::par_t pin = { .nthreads=4, .grain=1, .pin=true };
+        ra::for_each(pin, [&id0](int i){ id0[i] = std::this_thread::get_id(); }, ra::iota(400));
+        ra::for_each(pin, [&id1](int i){ id1[i] = std::this_thread::get_id(); }, ra::iota(400));
+        tr.test(id0==id1);
+        tr.test(std::this_thread::get_id()==id0[0]);
+    }
+    tr.section("assignment ops");
+    {
+        ra::assign_par = p4;
+        ra::Big<int, 2> a({40, 30}, 0);
+        a = ra::_0*100 + ra::_1;
+        tr.test_eq(ra::Big<int, 2>({40, 30}, ra::_0*100 + ra::_1), a);
+        a += ra::iota(40);
+        tr.test_eq(ra::Big<int, 2>({40, 30}, ra::_0*101 + ra::_1), a);
+// destination doesn't move along every axis, so this must run serially.
+        ra::Big<int, 1> s({40}, 0);
+        s += a;
+        tr.test_eq(ra::iota(40)*101*30 + 29*30/2, s);
+        ra::assign_par = ra::seq;
+    }
+    return tr.summary();
+}
@@ -331,6 +331,166 @@ int main()
         TEST(ply_fixed);
 #undef TEST
     }
+    tr.section("traversal order");
+    {
+        ra::Big<int, 2> a({3, 4}, ra::_0*4 + ra::_1);
+        auto check = [&](auto && b, auto && ref, auto && ... order)
+        {
+            std::vector<int> v;
+            ply(ra::map_([&v](int x) { v.push_back(x); }, iter(b)), ra::none, order ...);
+            tr.test_eq(ref, v);
+        };
+// by default, follow the steps.
+        check(a, ra::iota(12));
+        check(transpose(a), ra::iota(12));
+        check(ra::ViewBig<int *>(transpose(a)), ra::iota(12));
+        ra::Small<int, 3, 4> s = a;
+        check(transpose(s), ra::iota(12));
+// explicit order.
+        ra::Big<int, 1> rm({12}, ra::iota(12));
+        ra::Big<int, 1> cm = { 0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11 };
+        check(a, rm, ra::rowmajor);
+        check(a, cm, ra::ilist<1, 0>);
+        check(a, rm, ra::ilist<0, 1>);
+        check(transpose(a), cm, ra::rowmajor);
+        check(s, cm, ra::ilist<1, 0>);
+        check(transpose(s), cm, ra::rowmajor);
+        check(ra::ViewBig<int *>(a), cm, ra::ilist<1, 0>);
+// early exit is row-major.
+        std::vector<int> v;
+        early(ra::map_([&v](int x) { v.push_back(x); return std::optional<int> {}; }, iter(transpose(a))), 0);
+        tr.test_eq(cm, v);
+    }
+    tr.section("ply_ravel with different numbers of loops, inline or heap plan");
+    {
+        for (int r=1; r<=10; ++r) {
+            std::vector<ra::dim_t> s(r, 2);
+            std::vector<int> axes(r);
+            std::iota(axes.rbegin(), axes.rend(), 0);
+            ra::Big<int> b(s, ra::none);
+            std::iota(b.begin(), b.end(), 0);
+            ra::Big<int> c(s, 0);
+            c = transpose(b, axes); // can't ravel
+            bool ok = true;
+            for (int x=0; x<(1<<r); ++x) {
+                int y = 0;
+                for (int k=0; k<r; ++k) { y |= ((x>>k) & 1) << (r-1-k); }
+                ok = ok && (y==c.data()[x]);
+            }
+            tr.info("rank ", r).test(ok);
+            tr.info("rank ", r).test(every(c>=0));
+            tr.info("rank ", r).test(!any(c<0));
+        }
+    }
+    tr.section("unit step path");
+    {
+        ra::Big<int, 2> a({4, 5}, ra::_0*10 + ra::_1);
+        ra::Big<int, 2> b({4, 5}, ra::_0 - ra::_1);
+        ra::Big<int, 2> c({4, 5}, 0);
+        c = a*b + 3;
+        tr.test_eq(ra::Big<int, 2>({4, 5}, (ra::_0*10 + ra::_1)*(ra::_0 - ra::_1) + 3), c);
+// leaf with step 0 that does move.
+        ra::Big<int, 1> v = { 1, 2, 3, 4 };
+        c = v;
+        tr.test_eq(ra::Big<int, 2>({4, 5}, ra::_0+1), c);
+        ra::Big<int, 1> w = { 1, 2, 3, 4, 5 };
+        c = map(ra::wrank<0, 1>([](auto v, auto w){ return v - w; }), v, w);
+        tr.test_eq(ra::Big<int, 2>({4, 5}, ra::_0 - ra::_1), c);
+// static steps.
+        ra::Small<int, 3, 4> sa = ra::_0*10 + ra::_1, sb = 2;
+        sb += sa;
+        tr.test_eq(ra::_0*10 + ra::_1 + 2, sb);
+        sb = transpose(ra::Small<int, 4, 3>(transpose(sa)));
+        tr.test_eq(sa, sb);
+    }
+    tr.section("tiled traversal");
+    {
+        ra::Big<int, 2> a({70, 50}, ra::_0 - ra::_1);
+        ra::Big<int, 2> b({50, 70}, ra::_0 + 2*ra::_1);
+        auto test = [&](ra::tile_t const & t)
+        {
+            ra::Big<int, 2> c({70, 50}, 0);
+            for_each(t, [](auto & c, auto && x){ c = x; }, c, a + transpose(b));
+            tr.info("tile ", t.outer, " ", t.inner).test_eq(a + transpose(b), c);
+        };
+        test({});
+        test({1, 1});
+        test({16, 16});
+        test({7, 100});
+        test({100, 3});
+        ra::Big<int, 3> d({3, 4, 5}, 0);
+        ra::Big<int, 3> e({5, 4, 3}, ra::_0*100 + ra::_1*10 + ra::_2);
+        for_each(ra::tile_t {2, 2}, [](auto & d, auto && e){ d = e; }, d, transpose(e, ra::ilist<2, 1, 0>));
+        tr.test_eq(transpose(e, ra::ilist<2, 1, 0>), d);
+        ra::Big<int, 1> f({10}, 0);
+        for_each(ra::tile_t {}, [](auto & f, auto && i){ f = i; }, f, ra::iota(10));
+        tr.test_eq(ra::iota(10), f);
+// default tile side from the element sizes.
+        ra::Big<double, 2> g({3, 3}, 0.);
+        tr.test_eq(64, ra::tile_side<decltype(ra::iter(g))>);
+        tr.test_eq(32, ra::tile_side<decltype(map(std::plus<>(), g, transpose(g)))>);
+        tr.test_eq(ra::tile_side<decltype(ra::iter(g))>, ra::tile_side<decltype(map(std::plus<>(), g, ra::_0))>);
+        tr.test_eq(128, ra::tile_side<decltype(ra::_0 + ra::_1)>);
+    }
+    tr.section("ply_fixed raveling and unrolling");
+    {
+        using S34 = decltype(ra::iter(std::declval<ra::Small<int, 3, 4> &>()));
+        using T34 = decltype(ra::iter(transpose(std::declval<ra::Small<int, 4, 3> &>())));
+        tr.test_eq(2, ra::ply_ravel_s<S34, std::array {1, 0}>.first);
+        tr.test_eq(12, ra::ply_ravel_s<S34, std::array {1, 0}>.second);
+        tr.test_eq(1, ra::ply_ravel_s<T34, std::array {1, 0}>.first);
+        tr.test_eq(4, ra::ply_ravel_s<T34, std::array {1, 0}>.second);
+        auto test = [&]<int M, int N>(ra::ic_t<M>, ra::ic_t<N>){
+            ra::Small<int, M, N> c = 0;
+            int i = 0;
+            for_each([&i](auto & c){ c = i++; }, c);
+            tr.info(M, "x", N).test_eq(ra::_0*N + ra::_1, c);
+            ra::Small<int, N, M> d = 0;
+            d += transpose(c) + 1;
+            tr.info(M, "x", N, " transposed").test_eq(ra::_1*N + ra::_0 + 1, d);
+            tr.info(M, "x", N, " early").test_eq(M*N-1, ra::early(map([](auto c){ return M*N-1==c ? std::make_optional(c) : std::nullopt; }, c), -1));
+        };
+        test(ra::ic<1>, ra::ic<1>);
+        test(ra::ic<3>, ra::ic<3>);
+        test(ra::ic<4>, ra::ic<4>);
+        test(ra::ic<2>, ra::ic<16>);
+        test(ra::ic<6>, ra::ic<7>);
+        ra::Small<int, 2, 3, 4> e = ra::_0*100 + ra::_1*10 + ra::_2;
+        ra::Small<int, 2, 3, 4> f = 0;
+        f(ra::all, ra::all, ra::iota(ra::ic<2>, 1)) = e(ra::all, ra::all, ra::iota(ra::ic<2>, 1));
+        tr.test_eq(where(ra::_2==0 || ra::_2==3, 0, e), f);
+    }
+    tr.section("explain");
+    {
+        ra::Big<int, 2> a({4, 5}, 0);
+        ra::Big<int, 2> b({5, 4}, 0);
+        auto p = ra::explain(a);
+        tr.test(p.plyer=="ply_ravel");
+        tr.test(p.rank_static && !p.size_static);
+        tr.test_eq(20, p.size);
+        tr.test_eq(1, p.loops);
+        tr.test_eq(20, p.ss);
+        tr.test(p.unit);
+        p = ra::explain(a + transpose(b));
+        tr.test_eq(2, p.loops);
+        tr.test_eq(5, p.ss);
+        tr.test_eq(ra::start({0, 1}), ra::start(p.order));
+        tr.test_eq(ra::start({5, 1}), ra::start(p.steps[0]));
+        tr.test_eq(ra::start({1, 4}), ra::start(p.steps[1]));
+        tr.test(!p.unit);
+        p = ra::explain(a, ra::ilist_t<1, 0> {});
+        tr.test_eq(ra::start({1, 0}), ra::start(p.order));
+        tr.test_eq(2, p.loops);
+        ra::Small<int, 3, 4> s = 0;
+        p = ra::explain(s + ra::_1);
+        tr.test(p.plyer=="ply_fixed");
+        tr.test(p.size_static && p.unroll);
+        tr.test_eq(12, p.ss);
+        tr.test(p.lens_static[0] && p.lens_static[1]);
+        std::ostringstream o;
+        o << ra::explain(a);
+        tr.info(o.str()).test(o.str().starts_with("ply_ravel rank 2"));
+    }
     tr.section("more pliers on scalar");
     {
         tr.test_eq(-99, ra::map([](auto && x) { return -x; }, ra::scalar(99)));
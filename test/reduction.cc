@@ -422,5 +422,145 @@ int main()
         tr.test_eq(B, A);
         // cout << refmin(A+B) << endl; // compile error
     }
+    tr.section("accumulation policies");
+    {
+        ra::Big<float, 1> a({1<<22}, 0.1f);
+        double ref = 0.1f*double(1<<22);
+        tr.info("pairwise").test_rel(ref, sum(ra::pairwise, a), 1e-5);
+        tr.info("pairwise, block 7").test_rel(ref, sum(ra::pairwise_t {7}, a), 1e-5);
+        tr.info("kahan").test_rel(ref, sum(ra::kahan, a), 1e-7);
+        tr.info("kahan, block 8").test_rel(ref, sum(ra::kahan_t {8}, a), 1e-7);
+// blocks run across the lines.
+        auto b = ra::reshape(a, {1<<11, 1<<11});
+        tr.info("pairwise, rank 2").test_rel(ref, sum(ra::pairwise, transpose(b)), 1e-5);
+        tr.info("kahan, rank 2").test_rel(ref, sum(ra::kahan_t {100}, transpose(b)), 1e-6);
+        tr.info("widen").test_rel(ref, sum(ra::widen<double>, a), 1e-12);
+        tr.test_eq(true, std::is_same_v<double, decltype(sum(ra::widen<>, a))>);
+        tr.info("kahan dot").test_rel(ref*0.1f, dot(ra::kahan, a, a), 1e-7);
+        tr.info("widen dot").test_rel(ref*0.1f, dot(ra::widen<>, a, a), 1e-12);
+        tr.info("pairwise reduce_sqrm").test_rel(ref*0.1f, reduce_sqrm(ra::pairwise, a), 1e-5);
+        tr.info("kahan norm2").test_rel(std::sqrt(ref*0.1f), norm2(ra::kahan, a), 1e-7);
+        ra::par_t p4 = { .nthreads=4, .grain=1 };
+        tr.info("par kahan").test_rel(ref, sum(p4, ra::kahan, a), 1e-7);
+        tr.info("par pairwise").test_rel(ref, sum(p4, ra::pairwise, a), 1e-5);
+        ra::Big<std::complex<double>, 1> c({100}, ra::_0*ra::xi(1.));
+        tr.test_eq(sum(c), sum(ra::kahan, c));
+        tr.test_eq(reduce_sqrm(c), reduce_sqrm(ra::pairwise, c));
+        tr.test_eq(0., sum(ra::kahan, ra::Big<double, 1>({0}, 0.)));
+    }
+    tr.section("axis reductions");
+    {
+        ra::Big<int, 2> a({3, 4}, ra::_0*10 + ra::_1);
+        tr.test_eq(ra::Big<int, 1>({4}, 30 + 3*ra::_0), ra::reduce_axis<0>(std::plus<>(), a));
+        tr.test_eq(ra::Big<int, 1>({3}, 40*ra::_0 + 6), ra::reduce_axis<1>(std::plus<>(), a));
+        tr.test_eq(map([](auto && r){ return sum(r); }, iter<1>(a)), ra::reduce_axis<1>(std::plus<>(), a));
+        tr.test_eq(ra::reduce_axis<0>(std::plus<>(), a), ra::reduce_axis<1>(std::plus<>(), transpose(a)));
+        tr.test_eq(2*ra::reduce_axis<0>(std::plus<>(), a), ra::reduce_axis<0>(std::plus<>(), a*2));
+        tr.test_eq(ra::Big<int, 1>({4}, ra::sqr(ra::_0+1)*(ra::_0+1)), ra::reduce_axis<0>(std::multiplies<>(), ra::Big<int, 2>({3, 4}, ra::_1+1)));
+// inside an expression
+        ra::Big<int, 1> c = 1 + ra::reduce_axis<1>(std::plus<>(), a);
+        tr.test_eq(ra::Big<int, 1>({3}, 40*ra::_0 + 7), c);
+// as the source of an assignment, with ax outer in memory, this accumulates over c.
+        ra::Big<int, 1> d({4}, 0);
+        d = ra::reduce_axis<0>(std::plus<>(), a);
+        tr.test_eq(30 + 3*ra::iota(4), d);
+        d += ra::reduce_axis<0>(std::plus<>(), a);
+        tr.test_eq(2*(30 + 3*ra::iota(4)), d);
+        d = ra::reduce_axis<1>(std::plus<>(), transpose(a));
+        tr.test_eq(30 + 3*ra::iota(4), d);
+// the destination overlaps the source, or has a different shape, so a temporary is used.
+        ra::Big<int, 2> g({3, 4}, ra::_0+1);
+        g(0, ra::all) = ra::reduce_axis<0>(std::plus<>(), g);
+        tr.test_eq(ra::Big<int, 2> {{6, 6, 6, 6}, {2, 2, 2, 2}, {3, 3, 3, 3}}, g);
+        ra::Big<int, 2> h({4, 2}, 0);
+        h = ra::reduce_axis<0>(std::plus<>(), a);
+        tr.test_eq(30 + 3*ra::_0 + 0*h, h);
+// with and without initial value
+        auto mx = [](auto a, auto b){ return std::max(a, b); };
+        tr.test_eq(ra::Big<int, 1>({4}, 20 + ra::_0), ra::reduce_axis<0>(mx, a));
+        tr.test_eq(ra::Big<int, 1>({3}, 10*ra::_0 + 3), ra::reduce_axis<1>(mx, a));
+        tr.test_eq(ra::Big<int, 1>({3}, 15), ra::reduce_axis<1>(mx, 15, ra::Big<int, 2>({3, 4}, ra::_1)));
+        d = ra::reduce_axis<0>(mx, -1, a);
+        tr.test_eq(20 + ra::iota(4), d);
+// other ranks
+        ra::Big<int, 3> b({2, 3, 4}, ra::_0*100 + ra::_1*10 + ra::_2);
+        ra::Big<int, 2> e({2, 4}, 0);
+        e = ra::reduce_axis<1>(std::plus<>(), b);
+        tr.test_eq(ra::Big<int, 2>({2, 4}, 300*ra::_0 + 30 + 3*ra::_1), e);
+        tr.test_eq(ra::Big<int, 2>({3, 4}, 100 + 20*ra::_0 + 2*ra::_1), ra::reduce_axis<0>(std::plus<>(), b));
+        ra::Big<int> f({3, 4}, ra::_0*10 + ra::_1);
+        tr.test_eq(ra::Big<int, 1>({4}, 30 + 3*ra::_0), ra::reduce_axis<0>(std::plus<>(), f));
+    }
+    tr.section("scans");
+    {
+        ra::Big<int, 1> a({10}, ra::_0+1);
+        ra::Big<int, 1> y({10}, 0);
+        y = ra::scan(std::plus<>(), a);
+        tr.test_eq((ra::_0+1)*(ra::_0+2)/2, y);
+        y += ra::scan(std::plus<>(), a);
+        tr.test_eq((ra::_0+1)*(ra::_0+2), y);
+        y = ra::exscan(std::plus<>(), a);
+        tr.test_eq(ra::_0*(ra::_0+1)/2, y);
+        y = ra::exscan(std::plus<>(), 10, a*2);
+        tr.test_eq(10 + ra::_0*(ra::_0+1), y);
+        auto mx = [](auto a, auto b){ return std::max(a, b); };
+        ra::Big<int, 1> b = {3, 1, 4, 1, 5};
+        ra::Big<int, 1> z({5}, 0);
+        z = ra::scan(mx, b);
+        tr.test_eq(ra::Big<int, 1> {3, 3, 4, 4, 5}, z);
+        z = ra::exscan(mx, 0, b);
+        tr.test_eq(ra::Big<int, 1> {0, 3, 3, 4, 4}, z);
+        ra::Big<int, 1> e({0}, 0);
+        e = ra::scan(mx, e);
+        tr.test_eq(0, ra::size(e));
+// other axes
+        ra::Big<int, 2> c({3, 4}, 1);
+        ra::Big<int, 2> w({3, 4}, 0);
+        w = ra::scan<1>(std::plus<>(), c);
+        tr.test_eq(ra::_1+1 + 0*w, w);
+        w = ra::scan<0>(std::plus<>(), c);
+        tr.test_eq(ra::_0+1 + 0*w, w);
+        w = ra::exscan<0>(std::multiplies<>(), c+1);
+        tr.test_eq(ra::Big<int, 2> {{1, 1, 1, 1}, {2, 2, 2, 2}, {4, 4, 4, 4}}, w);
+// in place, and shifted, which needs a copy.
+        ra::Big<int, 1> f({10}, ra::_0+1);
+        f = ra::exscan(std::plus<>(), f);
+        tr.test_eq(ra::_0*(ra::_0+1)/2, f);
+        f = ra::_0+1;
+        f(ra::iota(9, 1)) = ra::exscan(std::plus<>(), f(ra::iota(9)));
+        tr.test_eq(ra::Big<int, 1> {1, 0, 1, 3, 6, 10, 15, 21, 28, 36}, f);
+        w = 1;
+        w = ra::exscan<0>(std::plus<>(), w);
+        tr.test_eq(ra::_0 + 0*w, w);
+    }
+    tr.section("parallel scans");
+    {
+        ra::par_t p4 = { .nthreads=4, .grain=1 };
+        ra::Big<long, 1> a({100001}, (ra::_0*7) % 13);
+        ra::Big<long, 1> y0({100001}, 0), y1({100001}, 0);
+        long s = 0;
+        for_each([&s](auto & y, auto a){ y = (s += a); }, y0, a);
+        ra::assign_par = p4;
+        y1 = ra::scan(std::plus<>(), a);
+        tr.test_eq(y0, y1);
+        y1 = ra::exscan(std::plus<>(), 5L, a);
+        tr.test_eq(5 + y0 - a, y1);
+        y1 = a;
+        y1 = ra::exscan(std::plus<>(), 5L, y1);
+        tr.test_eq(5 + y0 - a, y1);
+        y1 = a;
+        y1 = ra::scan(std::plus<>(), y1);
+        tr.test_eq(y0, y1);
+        y1 = ra::scan([](auto a, auto b){ return std::max(a, b); }, a);
+        tr.test_eq(ra::Big<long, 1> {0, 7, 7}, y1(ra::iota(3)));
+        tr.test_eq(12, y1(ra::iota(100001-11, 11)));
+        ra::Big<int, 2> c({100, 300}, ra::_1 % 3);
+        ra::Big<int, 2> w({100, 300}, 0);
+        w = ra::scan<1>(std::plus<>(), c);
+        tr.test_eq(map([](auto && c){ return sum(c); }, iter<1>(c)), w(ra::all, 299));
+        w = ra::scan<0>(std::plus<>(), c);
+        tr.test_eq(100*(ra::iota(300) % 3), w(99));
+        ra::assign_par = ra::seq;
+    }
     return tr.summary();
 }
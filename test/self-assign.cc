@@ -40,5 +40,74 @@ int main()
         tr.test_eq(A, ra::Big<int, 2> {{0, 0, 0, 0}, {4, 4, 4, 4}, {2, 2, 2, 2}, {4, 4, 4, 4}});
         tr.test_eq(B, ra::Big<int, 2> {{8, 8, 8, 8}, {2, 2, 2, 2}, {8, 8, 8, 8}, {0, 0, 0, 0}});
     }
+    tr.section("shifted self-assignment");
+    {
+        int n = 10;
+        auto ref = [&](auto && f){ ra::Big<int, 1> a({n}, ra::_0); ra::Big<int, 1> b = a; f(a, ra::Big<int, 1>(b)); return a; };
+        ra::Big<int, 1> a({n}, ra::_0);
+        a(ra::iota(n-1)) = a(ra::iota(n-1, 1));
+        tr.test_eq(ref([&](auto & a, auto const & b){ a(ra::iota(n-1)) = b(ra::iota(n-1, 1)); }), a);
+        a = ra::_0;
+        a(ra::iota(n-1, 1)) = a(ra::iota(n-1));
+        tr.test_eq(ref([&](auto & a, auto const & b){ a(ra::iota(n-1, 1)) = b(ra::iota(n-1)); }), a);
+        a = ra::_0;
+        a(ra::iota(n-3, 3)) += 2*a(ra::iota(n-3)) + a(ra::iota(n-3, 1));
+        tr.test_eq(ref([&](auto & a, auto const & b){ a(ra::iota(n-3, 3)) += 2*b(ra::iota(n-3)) + b(ra::iota(n-3, 1)); }), a);
+// negative steps.
+        a = ra::_0;
+        a(ra::iota(n-1, n-1, -1)) = a(ra::iota(n-1, n-2, -1));
+        tr.test_eq(ref([&](auto & a, auto const & b){ a(ra::iota(n-1, n-1, -1)) = b(ra::iota(n-1, n-2, -1)); }), a);
+// shifts in both directions need a temporary.
+        a = ra::_0;
+        a(ra::iota(n-2, 1)) = a(ra::iota(n-2)) + a(ra::iota(n-2, 2));
+        tr.test_eq(ref([&](auto & a, auto const & b){ a(ra::iota(n-2, 1)) = b(ra::iota(n-2)) + b(ra::iota(n-2, 2)); }), a);
+// reversal needs a temporary.
+        a = ra::_0;
+        a = a(ra::iota(n, n-1, -1));
+        tr.test_eq(n-1-ra::_0, a);
+    }
+    tr.section("shifted self-assignment, rank 2");
+    {
+        ra::Big<int, 2> a({5, 6}, ra::_0*10 + ra::_1);
+        a(ra::iota(4), ra::iota(5)) = a(ra::iota(4, 1), ra::iota(5, 1));
+        ra::Big<int, 2> b({5, 6}, ra::_0*10 + ra::_1);
+        b(ra::iota(4), ra::iota(5)) += 11;
+        tr.test_eq(b, a);
+        a = ra::_0*10 + ra::_1;
+        a(ra::iota(4, 1), ra::all) = a(ra::iota(4), ra::all);
+        b = ra::_0*10 + ra::_1;
+        b(ra::iota(4, 1), ra::all) -= 10;
+        tr.test_eq(b, a);
+// transpose of square block needs a temporary.
+        a = ra::_0*10 + ra::_1;
+        a(ra::all, ra::iota(5)) = transpose(a(ra::all, ra::iota(5)));
+        b = ra::_0*10 + ra::_1;
+        b(ra::all, ra::iota(5)) = ra::_1*10 + ra::_0;
+        tr.test_eq(b, a);
+// same element is fine.
+        a = ra::_0*10 + ra::_1;
+        a *= a;
+        tr.test_eq(sqr(ra::_0*10 + ra::_1), a);
+    }
+    tr.section("shifted self-assignment, static size");
+    {
+        ra::Small<int, 6> a = ra::_0;
+        a(ra::iota(ra::ic<5>)) = a(ra::iota(ra::ic<5>, 1));
+        tr.test_eq(ra::Small<int, 6> {1, 2, 3, 4, 5, 5}, a);
+        a = ra::_0;
+        a(ra::iota(ra::ic<5>, 1)) = a(ra::iota(ra::ic<5>));
+        tr.test_eq(ra::Small<int, 6> {0, 0, 1, 2, 3, 4}, a);
+// these need a temporary, which goes on the stack.
+        a = ra::_0;
+        a = a(ra::iota(ra::ic<6>, 5, -1));
+        tr.test_eq(ra::Small<int, 6> {5, 4, 3, 2, 1, 0}, a);
+        ra::Small<int, 3, 3> b = ra::_0*10 + ra::_1;
+        b = transpose(b);
+        tr.test_eq(ra::_1*10 + ra::_0, b);
+// no overlap.
+        ra::Small<int, 6> c = a;
+        c += a;
+        tr.test_eq(2*a, c);
+    }
     return tr.summary();
 }
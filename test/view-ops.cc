@@ -268,5 +268,41 @@ int main()
         // bv2(1, 1) = 9; // error
         tr.test_eq(ra::Big<int, 2>({{1, 2}, {3, 4}}), bv2);
     }
+    tr.section("view ops on expressions");
+    {
+        ra::Big<int, 2> a({3, 4}, ra::_0*10 + ra::_1);
+        ra::Big<int, 2> b({3, 4}, ra::_0 - ra::_1);
+        ra::Big<int, 1> v({3}, ra::_0*100);
+        tr.test_eq(transpose(a) + transpose(b), transpose(a + b));
+        tr.test_eq(transpose(a) + v(ra::insert<1>), transpose(a + v));
+        tr.test_eq(transpose(a) + ra::_0, transpose(a + ra::_1));
+        tr.test_eq(transpose(a, ilist<1, 0>) - 1, transpose(ra::map([](auto x){ return x-1; }, a), ilist<1, 0>));
+        tr.test_eq(reverse(a) * reverse(b), reverse(a * b));
+        tr.test_eq(reverse(a, ra::ic<1>) + v, reverse(a + v, ra::ic<1>));
+        tr.test_eq(reverse(a) + reverse(v), reverse(a + v));
+        ra::Big<int, 2> c({3, 3}, ra::_0*10 + ra::_1);
+        tr.test_eq(diag(c) + v, diag(c + v));
+        tr.test_eq(diag(c) + ra::iota(3), diag(c + ra::_1));
+        tr.test_eq(ra::pick(ra::iota(3) % 2, diag(c), diag(transpose(c))), diag(ra::pick(c % 2, c, transpose(c))));
+        tr.test_eq(a(1, ra::all) + b(1, ra::all), from(a + b, 1, ra::all));
+        tr.test_eq(a(ra::all, 2) + v, from(a + v, ra::all, 2));
+        tr.test_eq(a(1, 2) + v(1), from(a + v, 1, 2));
+        ra::Big<std::complex<double>, 2> m({3, 2}, ra::_0 + ra::xi(1.)*ra::_1);
+        ra::Big<std::complex<double>, 1> x({3}, 1.+ra::_0);
+        ra::Big<std::complex<double>, 2> mc = conj(m);
+        ra::Big<std::complex<double>, 1> y({2}, 0.);
+        gevm(x, conj(m), iter(y));
+        tr.test_eq(gevm(x, mc), y);
+        ra::Big<std::complex<double>, 1> x2({2}, 1.-ra::xi(1.)*ra::_0);
+        tr.test_eq(gemv(mc, x2), gemv(conj(m), x2));
+        tr.test_eq(gemv(mc, x2), gemv(conj(m), iter(x2)));
+        ra::Big<std::complex<double>, 1> z({3}, 0.);
+        gemv(conj(m), iter(x2), iter(z));
+        tr.test_eq(gemv(mc, x2), z);
+        z = 0.;
+        gemv(conj(m), x2+0., iter(z));
+        tr.test_eq(gemv(mc, x2), z);
+        tr.test_eq(transpose(a)(ra::all, 1) + transpose(b)(ra::all, 1), from(transpose(a + b), ra::all, 1));
+    }
     return tr.summary();
 }
@@ -175,6 +175,56 @@ int main()
         tr.test_eq(bool4 {true, true, true, false}, a || map([&](auto && b) { ++i; return b; }, b));
         tr.info("short circuit test for &&").test_eq(2, i);
     }
+    tr.section("compress");
+    {
+        ra::Big<int, 1> a({10}, ra::_0*ra::_0);
+        tr.test_eq(ra::Big<int, 1> { 0, 4, 16, 36, 64 }, compress(a%2==0, a));
+        tr.test_eq(ra::Big<int, 1> { 1, 3, 5, 7, 9 }, compress(a%2==1, ra::iota(10)));
+        tr.test_eq(0, ra::size(compress(a<0, a)));
+        ra::Big<double, 2> b({3, 4}, ra::_0*10 + ra::_1);
+        tr.test_eq(ra::Big<double, 1> { 2, 3, 12, 13, 22, 23 }, compress(ra::_1>=2, b));
+// mask is rank extended as in map.
+        ra::Big<bool, 1> m = { true, false, true };
+        tr.test_eq(ra::Big<double, 1> { 0, 1, 2, 3, 20, 21, 22, 23 }, compress(m, b));
+        tr.test_eq(ra::Big<double, 1> { 0, 1, 2, 3, 20, 21, 22, 23 }, compress(m, transpose(transpose(b))));
+        tr.test_eq(ra::Big<double, 1> { 1, 11, 21 }, compress(ra::_0==1, transpose(b)));
+    }
+    tr.section("nonzero");
+    {
+        ra::Big<int, 1> a = { 0, 3, 0, 0, 1, 2 };
+        auto i = nonzero(a!=0);
+        tr.test_eq(1, ra::rank(i));
+        tr.test_eq(ra::Big<ra::dim_t, 1> { 1, 4, 5 }, i);
+        tr.test_eq(compress(a!=0, a), a(i));
+        ra::Big<int, 2> b({3, 3}, ra::_0 - ra::_1);
+        auto j = nonzero(b==0);
+        tr.test_eq(ra::Big<ra::dim_t, 2>({3, 2}, { 0, 0, 1, 1, 2, 2 }), j);
+        tr.test_eq(ra::Big<ra::dim_t, 2>({0, 2}, 0), nonzero(b>5));
+        ra::Big<int> c({2, 2, 2}, ra::_0 + ra::_1 + ra::_2);
+        tr.test_eq(ra::Big<ra::dim_t, 2>({2, 3}, { 0, 0, 0, 1, 1, 1 }), nonzero(c%3==0));
+// runtime rank 1 gives indices that can be used as a subscript, as for static rank 1.
+        ra::Big<int> d({6}, { 0, 3, 0, 0, 1, 2 });
+        auto k = nonzero(d!=0);
+        tr.test_eq(1, ra::rank(k));
+        tr.test_eq(ra::Big<ra::dim_t, 1> { 1, 4, 5 }, k);
+        tr.test_eq(compress(d!=0, d), d(k));
+        tr.test_eq(2, ra::rank(nonzero(c%3==0)));
+        tr.test_eq(1, ra::rank(nonzero(d>5)));
+        tr.test_eq(0, ra::size(nonzero(d>5)));
+    }
+    tr.section("compress and nonzero in parallel");
+    {
+        constexpr ra::par_t p4 = { .nthreads=4, .grain=1 };
+        ra::Big<int, 2> a({101, 13}, (ra::_0*13 + ra::_1) % 7);
+        tr.test_eq(compress(a==3, a*100 + ra::_1), compress(p4, a==3, a*100 + ra::_1));
+        tr.test_eq(nonzero(a==3), nonzero(p4, a==3));
+        ra::Big<int, 1> b({1000}, ra::_0);
+        tr.test_eq(ra::iota(334, 0, 3), compress(p4, b%3==0, b));
+        tr.test_eq(ra::iota(334, 0, 3), nonzero(p4, b%3==0));
+        tr.test_eq(ra::iota(2), compress(p4, ra::Big<bool, 1> { true, true }, ra::iota(2)));
+        ra::Big<int> c({1000}, ra::_0);
+        tr.test_eq(ra::iota(334, 0, 3), nonzero(p4, c%3==0));
+    }
 // These tests should fail at compile time. No way to check them yet [ra42].
     // tr.section("size checks");
     // {